@@ -10,6 +10,10 @@
  */
 #include "FSCommon.h"
 #include "configuration.h"
+#include <stdint.h>
+#ifdef ARCH_PORTDUINO
+#include <sys/statvfs.h>
+#endif
 
 #ifdef HAS_SDCARD
 #include <SD.h>
@@ -84,6 +88,36 @@ bool renameFile(const char *pathFrom, const char *pathTo)
 #endif
 }
 
+/**
+ * How much space is left on the filesystem.
+ *
+ * @return The free bytes, or SIZE_MAX where the filesystem can't tell.
+ */
+size_t fsFreeBytes()
+{
+#if defined(ARCH_ESP32)
+    return FSCom.totalBytes() - FSCom.usedBytes();
+#elif defined(ARCH_NRF52)
+    // Adafruit's LittleFS has no usage API, so count the blocks in use
+    lfs_t *lfs = FSCom._getFS();
+    lfs_size_t used = 0;
+    auto countBlock = [](void *count, lfs_block_t block) {
+        (*(lfs_size_t *)count)++;
+        return 0;
+    };
+    if (lfs_traverse(lfs, countBlock, &used) < 0 || used > lfs->cfg->block_count)
+        return 0;
+    return (lfs->cfg->block_count - used) * lfs->cfg->block_size;
+#elif defined(ARCH_PORTDUINO)
+    struct statvfs st;
+    if (statvfs(portduinoVFS->mountpoint(), &st) != 0)
+        return SIZE_MAX;
+    return st.f_bavail * st.f_frsize;
+#else
+    return SIZE_MAX;
+#endif
+}
+
 /**
  * Lists the contents of a directory.
  *
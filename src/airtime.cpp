@@ -9,6 +9,9 @@ AirTime *airTime = NULL;
 uint32_t air_period_tx[PERIODS_TO_LOG];
 uint32_t air_period_rx[PERIODS_TO_LOG];
 
+// Per second smoothing factors for the utilizationWindows, 1 - exp(-1 / seconds)
+static const float utilizationAlpha[UTIL_WINDOWS] = {0.6321f, 0.0952f, 0.0165f};
+
 void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
 {
 
@@ -18,6 +21,7 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
         air_period_tx[0] = air_period_tx[0] + airtime_ms;
 
         this->utilizationTX[this->getPeriodUtilHour()] = this->utilizationTX[this->getPeriodUtilHour()] + airtime_ms;
+        utilizationTXSum += airtime_ms;
     } else if (reportType == RX_LOG) {
         LOG_DEBUG("AirTime - Packet received : %ums\n", airtime_ms);
         this->airtimes.periodRX[0] = this->airtimes.periodRX[0] + airtime_ms;
@@ -29,6 +33,8 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
 
     // Log all airtime type for channel utilization
     this->channelUtilization[this->getPeriodUtilMinute()] = channelUtilization[this->getPeriodUtilMinute()] + airtime_ms;
+    channelUtilizationSum += airtime_ms;
+    pendingAirtimeMsec += airtime_ms;
 }
 
 uint8_t AirTime::currentPeriodIndex()
@@ -102,23 +108,26 @@ uint32_t AirTime::getSecondsSinceBoot()
 
 float AirTime::channelUtilizationPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-        sum += this->channelUtilization[i];
-        // LOG_DEBUG("ChanUtilArray %u %u\n", i, this->channelUtilization[i]);
-    }
-
-    return (float(sum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
+    return (float(channelUtilizationSum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
 }
 
 float AirTime::utilizationTXPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-        sum += this->utilizationTX[i];
-    }
+    return (float(utilizationTXSum) / float(MS_IN_HOUR)) * 100;
+}
 
-    return (float(sum) / float(MS_IN_HOUR)) * 100;
+float AirTime::channelUtilizationEWMA(utilizationWindows window)
+{
+    return channelUtilizationAvg[window];
+}
+
+/**
+ * Channel utilization to size contention windows with. The minute average is slow to notice a burst of traffic,
+ * so use the ten second view whenever it is the busier of the two.
+ */
+float AirTime::congestionPercent()
+{
+    return max(channelUtilizationPercent(), channelUtilizationAvg[UTIL_WINDOW_10S]);
 }
 
 bool AirTime::isTxAllowedChannelUtil(bool polite)
@@ -179,6 +188,8 @@ int32_t AirTime::runOnce()
         for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
             this->channelUtilization[i] = 0;
         }
+        channelUtilizationSum = 0;
+        utilizationTXSum = 0;
 
         // Init airtime windows to all 0
         for (int i = 0; i < PERIODS_TO_LOG; i++) {
@@ -199,15 +210,25 @@ int32_t AirTime::runOnce()
         if (lastUtilPeriod != utilPeriod) {
             lastUtilPeriod = utilPeriod;
 
+            channelUtilizationSum -= this->channelUtilization[utilPeriod];
             this->channelUtilization[utilPeriod] = 0;
         }
 
         if (lastUtilPeriodTX != utilPeriodTX) {
             lastUtilPeriodTX = utilPeriodTX;
 
+            utilizationTXSum -= this->utilizationTX[utilPeriodTX];
             this->utilizationTX[utilPeriodTX] = 0;
         }
     }
+
+    // Airtime is logged when a packet ends, so spread anything longer than this second over the following ones
+    uint32_t airtimeThisSecond = min(pendingAirtimeMsec, (uint32_t)1000);
+    pendingAirtimeMsec -= airtimeThisSecond;
+    float utilThisSecond = airtimeThisSecond / 10.0f;
+    for (int i = 0; i < UTIL_WINDOWS; i++) {
+        channelUtilizationAvg[i] += utilizationAlpha[i] * (utilThisSecond - channelUtilizationAvg[i]);
+    }
     /*
         LOG_DEBUG("utilPeriodTX %d TX Airtime %3.2f%\n", utilPeriodTX, airTime->utilizationTXPercent());
         for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
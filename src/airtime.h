@@ -35,6 +35,12 @@
 
 enum reportTypes { TX_LOG, RX_LOG, RX_ALL_LOG };
 
+/*
+  Exponentially weighted views of channel utilization, updated once a second. The time
+  constant is roughly how far back each one looks.
+*/
+enum utilizationWindows { UTIL_WINDOW_1S, UTIL_WINDOW_10S, UTIL_WINDOW_60S, UTIL_WINDOWS };
+
 void logAirtime(reportTypes reportType, uint32_t airtime_ms);
 
 uint32_t *airtimeReport(reportTypes reportType);
@@ -48,6 +54,8 @@ class AirTime : private concurrency::OSThread
     void logAirtime(reportTypes reportType, uint32_t airtime_ms);
     float channelUtilizationPercent();
     float utilizationTXPercent();
+    float channelUtilizationEWMA(utilizationWindows window);
+    float congestionPercent();
 
     float UtilizationPercentTX();
     uint32_t channelUtilization[CHANNEL_UTILIZATION_PERIODS] = {0};
@@ -71,6 +79,13 @@ class AirTime : private concurrency::OSThread
     uint8_t polite_channel_util_percent = 25;
     uint8_t polite_duty_cycle_percent = 50; // half of Duty Cycle allowance is ok for metadata
 
+    // Running totals of channelUtilization[] and utilizationTX[], so the percentages don't re-sum the arrays
+    uint32_t channelUtilizationSum = 0;
+    uint32_t utilizationTXSum = 0;
+
+    uint32_t pendingAirtimeMsec = 0;                // Airtime logged but not yet folded into the EWMAs
+    float channelUtilizationAvg[UTIL_WINDOWS] = {0}; // Percent, see utilizationWindows
+
     struct airtimeStruct {
         uint32_t periodTX[PERIODS_TO_LOG];     // AirTime transmitted
         uint32_t periodRX[PERIODS_TO_LOG];     // AirTime received and repeated (Only valid mesh packets)
@@ -0,0 +1,34 @@
+#include "GeoCache.h"
+#include "GeoCoord.h"
+#include <string.h>
+
+GeoCache geoCache;
+
+GeoRelation GeoCache::get(uint32_t key, int32_t ourLat, int32_t ourLon, int32_t theirLat, int32_t theirLon)
+{
+    // We moved: every cached result is stale
+    if (ourLat != originLatitude || ourLon != originLongitude) {
+        clear();
+        originLatitude = ourLat;
+        originLongitude = ourLon;
+    }
+
+    // Direct-mapped: each node can only live in one slot
+    Entry &e = entries[key % GEO_CACHE_SIZE];
+    if (key != 0 && e.key == key && e.latitude == theirLat && e.longitude == theirLon)
+        return e.relation;
+
+    GeoRelation r;
+    GeoCoord::distanceAndBearingFast(ourLat, ourLon, theirLat, theirLon, r.distance, r.bearing);
+
+    e.key = key;
+    e.latitude = theirLat;
+    e.longitude = theirLon;
+    e.relation = r;
+    return r;
+}
+
+void GeoCache::clear()
+{
+    memset(entries, 0, sizeof(entries));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Number of nodes whose distance and bearing are remembered
+#ifndef GEO_CACHE_SIZE
+#define GEO_CACHE_SIZE 32
+#endif
+
+/// Distance and bearing from our position to another point
+struct GeoRelation {
+    float distance; // meters
+    float bearing;  // radians, 0 is due north
+};
+
+/**
+ * Remembers the distance and bearing from our position to other nodes, so that frames which are redrawn
+ * repeatedly (and lists sorted by distance) don't repeat the trig each time.
+ *
+ * Results come from GeoCoord::distanceAndBearingFast(). Entries are keyed by node number (0 is reserved), and are only
+ * reused while neither position has changed. If our own position changes, the whole cache is dropped.
+ */
+class GeoCache
+{
+  public:
+    /// Distance and bearing from our position to theirs. Coordinates in 1e-7 degrees
+    GeoRelation get(uint32_t key, int32_t ourLat, int32_t ourLon, int32_t theirLat, int32_t theirLon);
+
+    /// Forget all cached results
+    void clear();
+
+  private:
+    struct Entry {
+        uint32_t key;
+        int32_t latitude;
+        int32_t longitude;
+        GeoRelation relation;
+    };
+
+    Entry entries[GEO_CACHE_SIZE] = {};
+    int32_t originLatitude = 0;
+    int32_t originLongitude = 0;
+};
+
+extern GeoCache geoCache;
@@ -399,6 +399,72 @@ float GeoCoord::latLongToMeter(double lat_a, double lng_a, double lat_b, double
     return (float)(6366000 * tt);
 }
 
+/**
+ * Distance and bearing between two points, using only single-precision math.
+ * On MCUs without a double-precision FPU this is much cheaper than latLongToMeter() + bearing(), which do their
+ * trig in software doubles. Deltas are taken in integer form, so no precision is lost for nearby points.
+ *
+ * Short ranges use the equirectangular (flat-earth) approximation; longer ranges fall back to haversine.
+ *
+ * @param distance
+ * Distance in meters, along the globe surface
+ * @param bearing
+ * Bearing from point a to point b in radians. A value of 0 means due north.
+ */
+void GeoCoord::distanceAndBearingFast(int32_t lat_a, int32_t lng_a, int32_t lat_b, int32_t lng_b, float &distance,
+                                      float &bearing)
+{
+    const float E7_TO_RADIANS = (float)(PI / 180 * 1e-7);
+    const float EARTH_RADIUS = 6366000; // Match latLongToMeter()
+
+    if (lat_a == lat_b && lng_a == lng_b) {
+        distance = 0;
+        bearing = 0;
+        return;
+    }
+
+    // Longitude delta, wrapped across the antimeridian
+    int64_t dLngE7 = (int64_t)lng_b - lng_a;
+    if (dLngE7 > 1800000000LL)
+        dLngE7 -= 3600000000LL;
+    else if (dLngE7 < -1800000000LL)
+        dLngE7 += 3600000000LL;
+
+    const float dLat = (float)((int64_t)lat_b - lat_a) * E7_TO_RADIANS;
+    const float dLng = (float)dLngE7 * E7_TO_RADIANS;
+
+    // Equirectangular
+    const float meanLat = (float)(((int64_t)lat_a + lat_b) / 2) * E7_TO_RADIANS;
+    const float x = dLng * cosf(meanLat);
+    const float y = dLat;
+    distance = EARTH_RADIUS * sqrtf(x * x + y * y);
+    if (distance < GEO_EQUIRECT_MAX_METERS) {
+        bearing = atan2f(x, y);
+        return;
+    }
+
+    // Haversine
+    const float latA = lat_a * E7_TO_RADIANS;
+    const float latB = lat_b * E7_TO_RADIANS;
+    const float cosLatA = cosf(latA);
+    const float cosLatB = cosf(latB);
+    const float sinHalfDLat = sinf(dLat / 2);
+    const float sinHalfDLng = sinf(dLng / 2);
+    float h = sinHalfDLat * sinHalfDLat + cosLatA * cosLatB * sinHalfDLng * sinHalfDLng;
+    if (h > 1)
+        h = 1;
+    distance = 2 * EARTH_RADIUS * asinf(sqrtf(h));
+    bearing = atan2f(sinf(dLng) * cosLatB, cosLatA * sinf(latB) - sinf(latA) * cosLatB * cosf(dLng));
+}
+
+/// Distance in meters between two points, using only single-precision math. See distanceAndBearingFast()
+float GeoCoord::latLongToMeterFast(int32_t lat_a, int32_t lng_a, int32_t lat_b, int32_t lng_b)
+{
+    float distance, bearing;
+    distanceAndBearingFast(lat_a, lng_a, lat_b, lng_b, distance, bearing);
+    return distance;
+}
+
 /**
  * Computes the bearing in degrees between two points on Earth.  Ported from my
  * old Gaggle android app.
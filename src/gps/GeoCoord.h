@@ -13,6 +13,11 @@
 #define OLC_CODE_LEN 11
 #define DEG_CONVERT (180 / PI)
 
+// Beyond this range, the fast distance calculation switches from a flat-earth approximation to haversine
+#ifndef GEO_EQUIRECT_MAX_METERS
+#define GEO_EQUIRECT_MAX_METERS 50000
+#endif
+
 // Helper functions
 // Raises a number to an exponent, handling negative exponents.
 static inline double pow_neg(double base, double exponent)
@@ -118,6 +123,11 @@ class GeoCoord
     static float rangeRadiansToMeters(double range_radians);
     static float rangeMetersToRadians(double range_meters);
 
+    // Single-precision alternatives to latLongToMeter and bearing. Coordinates in 1e-7 degrees
+    static void distanceAndBearingFast(int32_t lat_a, int32_t lng_a, int32_t lat_b, int32_t lng_b, float &distance,
+                                       float &bearing);
+    static float latLongToMeterFast(int32_t lat_a, int32_t lng_a, int32_t lat_b, int32_t lng_b);
+
     // Point to point conversions
     int32_t distanceTo(const GeoCoord &pointB);
     int32_t bearingTo(const GeoCoord &pointB);
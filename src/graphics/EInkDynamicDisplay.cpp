@@ -50,8 +50,15 @@ void EInkDynamicDisplay::configForFastRefresh()
 #if defined(PRIVATE_HW)
 #else
     // Otherwise:
+#ifdef EINK_PARTIAL_REGIONS
+    // Only redraw the rows which have changed since the previous update
+    uint16_t top, height;
+    findChangedRows(&top, &height);
+    adafruitDisplay->setPartialWindow(0, top, adafruitDisplay->width(), height);
+#else
     adafruitDisplay->setPartialWindow(0, 0, adafruitDisplay->width(), adafruitDisplay->height());
 #endif
+#endif
 }
 
 // GxEPD2 code to set full refresh
@@ -74,6 +81,12 @@ void EInkDynamicDisplay::applyRefreshMode()
         currentConfig = FAST;
     }
 
+#ifdef EINK_PARTIAL_REGIONS
+    // Partial window follows whichever region changed, so must be set again for every FAST refresh
+    else if (currentConfig == FAST && refresh == FAST)
+        configForFastRefresh();
+#endif
+
     // Change from FAST back to FULL
     else if (currentConfig == FAST && refresh == FULL) {
         configForFullRefresh();
@@ -371,14 +384,118 @@ void EInkDynamicDisplay::resetRateLimiting()
 // Generate a hash of this frame, to compare against previous update
 void EInkDynamicDisplay::hashImage()
 {
-    imageHash = 0;
+#ifdef EINK_PARTIAL_REGIONS
+    // Hash each band of the image individually, then combine them into a hash of the whole frame
+    hashRegions();
+    imageHash = hashBytes((uint8_t *)regionHashes, sizeof(regionHashes));
+#else
+    imageHash = hashBytes(buffer, displayBufferSize);
+#endif
+}
+
+// xxHash32 - a fast non-cryptographic hash. Unlike a byte sum, reordered or swapped pixels will change the result
+uint32_t EInkDynamicDisplay::hashBytes(const uint8_t *data, uint32_t length, uint32_t seed)
+{
+    constexpr uint32_t PRIME1 = 2654435761U;
+    constexpr uint32_t PRIME2 = 2246822519U;
+    constexpr uint32_t PRIME3 = 3266489917U;
+    constexpr uint32_t PRIME4 = 668265263U;
+    constexpr uint32_t PRIME5 = 374761393U;
+
+    auto rotl = [](uint32_t x, uint8_t r) { return (x << r) | (x >> (32 - r)); };
+    auto read32 = [](const uint8_t *p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v)); // Buffer is not guaranteed to be word-aligned
+        return v;
+    };
+
+    const uint8_t *p = data;
+    const uint8_t *end = data + length;
+    uint32_t h;
+
+    // Main loop: four independent lanes, 16 bytes per iteration
+    if (length >= 16) {
+        uint32_t v1 = seed + PRIME1 + PRIME2;
+        uint32_t v2 = seed + PRIME2;
+        uint32_t v3 = seed;
+        uint32_t v4 = seed - PRIME1;
+        const uint8_t *limit = end - 16;
+        do {
+            v1 = rotl(v1 + read32(p) * PRIME2, 13) * PRIME1;
+            v2 = rotl(v2 + read32(p + 4) * PRIME2, 13) * PRIME1;
+            v3 = rotl(v3 + read32(p + 8) * PRIME2, 13) * PRIME1;
+            v4 = rotl(v4 + read32(p + 12) * PRIME2, 13) * PRIME1;
+            p += 16;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    } else
+        h = seed + PRIME5;
+
+    h += length;
+
+    // Remaining words, then remaining bytes
+    for (; p + 4 <= end; p += 4)
+        h = rotl(h + read32(p) * PRIME3, 17) * PRIME4;
+    for (; p < end; p++)
+        h = rotl(h + (*p) * PRIME5, 11) * PRIME1;
+
+    // Avalanche
+    h ^= h >> 15;
+    h *= PRIME2;
+    h ^= h >> 13;
+    h *= PRIME3;
+    h ^= h >> 16;
+    return h;
+}
+
+#ifdef EINK_PARTIAL_REGIONS
+// Hash each horizontal band of the image separately, so we can find which part of the frame has changed
+void EInkDynamicDisplay::hashRegions()
+{
+    // OLEDDisplay buffer is page-based: each run of displayWidth bytes holds 8 rows of pixels
+    const uint16_t pageCount = (displayHeight + 7) / 8;
 
-    // Sum all bytes of the image buffer together
-    for (uint16_t b = 0; b < (displayWidth / 8) * displayHeight; b++) {
-        imageHash += buffer[b];
+    for (uint8_t r = 0; r < EINK_PARTIAL_REGIONS; r++) {
+        const uint16_t firstPage = (pageCount * r) / EINK_PARTIAL_REGIONS;
+        const uint16_t endPage = (pageCount * (r + 1)) / EINK_PARTIAL_REGIONS;
+        regionHashes[r] = hashBytes(buffer + (firstPage * displayWidth), (endPage - firstPage) * displayWidth, r);
     }
 }
 
+// Get the span of rows covered by any regions which changed since the previous update
+void EInkDynamicDisplay::findChangedRows(uint16_t *top, uint16_t *height)
+{
+    const uint16_t pageCount = (displayHeight + 7) / 8;
+    int16_t firstChanged = -1;
+    int16_t lastChanged = -1;
+
+    for (uint8_t r = 0; r < EINK_PARTIAL_REGIONS; r++) {
+        if (regionHashes[r] != previousRegionHashes[r]) {
+            if (firstChanged < 0)
+                firstChanged = r;
+            lastChanged = r;
+        }
+    }
+
+    // Nothing changed (a DEMAND_FAST redraw?): use the whole display
+    if (firstChanged < 0) {
+        *top = 0;
+        *height = adafruitDisplay->height();
+        return;
+    }
+
+    // Convert regions -> pages -> rows
+    const uint16_t firstRow = ((pageCount * firstChanged) / EINK_PARTIAL_REGIONS) * 8;
+    uint16_t endRow = ((pageCount * (lastChanged + 1)) / EINK_PARTIAL_REGIONS) * 8;
+    if (endRow > adafruitDisplay->height())
+        endRow = adafruitDisplay->height();
+
+    *top = firstRow;
+    *height = endRow - firstRow;
+    LOG_DEBUG("partial window rows %hu-%hu, ", firstRow, endRow);
+}
+#endif // EINK_PARTIAL_REGIONS
+
 // Store the results of determineMode() for future use, and reset for next call
 void EInkDynamicDisplay::storeAndReset()
 {
@@ -389,6 +506,9 @@ void EInkDynamicDisplay::storeAndReset()
     // Only store image hash if the display will update
     if (refresh != SKIPPED) {
         previousImageHash = imageHash;
+#ifdef EINK_PARTIAL_REGIONS
+        memcpy(previousRegionHashes, regionHashes, sizeof(regionHashes));
+#endif
     }
 
     frameFlags = BACKGROUND;
@@ -406,24 +526,28 @@ void EInkDynamicDisplay::countGhostPixels()
     // Start a new count
     ghostPixelCount = 0;
 
-    // Check new image, bit by bit, for any white pixels at locations marked "dirty"
-    for (uint16_t i = 0; i < displayBufferSize; i++) {
-        for (uint8_t bit = 0; bit < 7; bit++) {
+    // Process the image one word at a time:
+    // a ghost pixel is any location marked "dirty" which is white (unset) in the new image
+    const uint32_t wordCount = displayBufferSize / sizeof(uint32_t);
+    for (uint32_t w = 0; w < wordCount; w++) {
+        uint32_t dirty, image;
+        memcpy(&dirty, dirtyPixels + (w * sizeof(uint32_t)), sizeof(uint32_t));
+        memcpy(&image, buffer + (w * sizeof(uint32_t)), sizeof(uint32_t));
 
-            const bool dirty = (dirtyPixels[i] >> bit) & 1;       // Has pixel location been drawn to since full-refresh?
-            const bool shouldBeBlank = !((buffer[i] >> bit) & 1); // Is pixel location white in the new image?
+        ghostPixelCount += __builtin_popcount(dirty & ~image);
 
-            // If pixel is (or has been) black since last full-refresh, and now is white: ghosting
-            if (dirty && shouldBeBlank)
-                ghostPixelCount++;
+        // Any pixel which is black in the new image becomes dirty - will become a ghost if set white in future
+        dirty |= image;
+        memcpy(dirtyPixels + (w * sizeof(uint32_t)), &dirty, sizeof(uint32_t));
+    }
 
-            // Update the dirty status for this pixel - will this location become a ghost if set white in future?
-            if (!dirty && !shouldBeBlank)
-                dirtyPixels[i] |= (1 << bit);
-        }
+    // Leftover bytes, if buffer size is not a multiple of the word size
+    for (uint32_t i = wordCount * sizeof(uint32_t); i < displayBufferSize; i++) {
+        ghostPixelCount += __builtin_popcount((uint8_t)(dirtyPixels[i] & ~buffer[i]));
+        dirtyPixels[i] |= buffer[i];
     }
 
-    LOG_DEBUG("ghostPixels=%hu, ", ghostPixelCount);
+    LOG_DEBUG("ghostPixels=%lu, ", ghostPixelCount);
 }
 
 // Check if ghost pixel count exceeds the defined limit
@@ -89,6 +89,7 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
 
     void resetRateLimiting(); // Set previousRunMs - this now counts as an update, for rate-limiting
     void hashImage();         // Generate a hashed version of this frame, to compare against previous update
+    static uint32_t hashBytes(const uint8_t *data, uint32_t length, uint32_t seed = 0); // xxHash32 of a block of memory
     void storeAndReset();     // Keep results of determineMode() for later, tidy-up for next call
 
     // What we are determining for this frame
@@ -117,6 +118,14 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     uint32_t ghostPixelCount = 0;   // Number of pixels with problematic ghosting. Retained here for LOG_DEBUG use
 #endif
 
+    // Optional - hash the image in horizontal bands, so fast-refresh only redraws the changed rows
+#ifdef EINK_PARTIAL_REGIONS
+    void hashRegions();                                        // Hash each band of the image individually
+    void findChangedRows(uint16_t *top, uint16_t *height);     // Span of rows whose bands differ from previous update
+    uint32_t regionHashes[EINK_PARTIAL_REGIONS] = {0};         // Hash of each band of the current frame
+    uint32_t previousRegionHashes[EINK_PARTIAL_REGIONS] = {0}; // Hash of each band of the previous update's frame
+#endif
+
     // Conditional - async full refresh - only with modified meshtastic/GxEPD2
 #if defined(HAS_EINK_ASYNCFULL)
   public:
@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "error.h"
+#include "gps/GeoCache.h"
 #include "gps/GeoCoord.h"
 #include "gps/RTC.h"
 #include "graphics/ScreenFonts.h"
@@ -74,6 +75,11 @@ namespace graphics
 
 // A text message frame + debug frame + all the node infos
 FrameCallback *normalFrames;
+// Which data each of the normalFrames displays (Screen::FrameDependency flags)
+static uint8_t *normalFrameDependencies;
+static size_t numNormalFrames;
+// When the content of a DEPENDS_CLOCK frame will next change
+static uint32_t frameExpiresMs;
 static uint32_t targetFramerate = IDLE_FRAMERATE;
 static char btPIN[16] = "888888";
 
@@ -112,6 +118,28 @@ static uint16_t displayWidth, displayHeight;
 
 #define getStringCenteredX(s) ((SCREEN_WIDTH - display->getStringWidth(s)) / 2)
 
+/// Called while drawing a DEPENDS_CLOCK frame: its content will not change for this long, unless other dependencies change
+static void setFrameExpiry(uint32_t msec)
+{
+    frameExpiresMs = millis() + msec;
+}
+
+/// How long until a time delta, as formatted by Screen::drawTimeDelta, shows a different value
+static uint32_t msecUntilTimeDeltaChanges(uint32_t seconds)
+{
+    uint32_t unit;
+    if (seconds >= 2 * SEC_PER_DAY)
+        unit = SEC_PER_DAY;
+    else if (seconds >= 2 * SEC_PER_HOUR)
+        unit = SEC_PER_HOUR;
+    else if (seconds >= SEC_PER_MIN)
+        unit = SEC_PER_MIN;
+    else
+        unit = 1;
+
+    return (unit - (seconds % unit)) * 1000;
+}
+
 /**
  * Draw the icon with extra info printed around the corners
  */
@@ -427,6 +455,7 @@ static void drawTextMessageFrame(OLEDDisplay *display, OLEDDisplayUiState *state
     uint32_t minutes = seconds / 60;
     uint32_t hours = minutes / 60;
     uint32_t days = hours / 24;
+    setFrameExpiry(msecUntilTimeDeltaChanges(seconds));
 
     if (config.display.heading_bold) {
         display->drawStringf(1 + x, 0 + y, tempBuf, "%s ago from %s",
@@ -460,6 +489,7 @@ static void drawWaypointFrame(OLEDDisplay *display, OLEDDisplayUiState *state, i
     uint32_t minutes = seconds / 60;
     uint32_t hours = minutes / 60;
     uint32_t days = hours / 24;
+    setFrameExpiry(msecUntilTimeDeltaChanges(seconds));
 
     if (config.display.heading_bold) {
         display->drawStringf(1 + x, 0 + y, tempBuf, "%s ago from %s",
@@ -730,9 +760,10 @@ static void drawLine(OLEDDisplay *d, const Point &p1, const Point &p2)
  * We keep a series of "after you've gone 10 meters, what is your heading since
  * the last reference point?"
  */
-static float estimatedHeading(double lat, double lon)
+static float estimatedHeading(int32_t lat, int32_t lon)
 {
-    static double oldLat, oldLon;
+    static int32_t oldLat, oldLon;
+    static int32_t lastLat, lastLon;
     static float b;
 
     if (oldLat == 0) {
@@ -743,11 +774,18 @@ static float estimatedHeading(double lat, double lon)
         return b;
     }
 
-    float d = GeoCoord::latLongToMeter(oldLat, oldLon, lat, lon);
+    // Position hasn't changed since we last looked, nothing to recalculate
+    if (lat == lastLat && lon == lastLon)
+        return b;
+    lastLat = lat;
+    lastLon = lon;
+
+    float d, newBearing;
+    GeoCoord::distanceAndBearingFast(oldLat, oldLon, lat, lon, d, newBearing);
     if (d < 10) // haven't moved enough, just keep current bearing
         return b;
 
-    b = GeoCoord::bearing(oldLat, oldLon, lat, lon);
+    b = newBearing;
     oldLat = lat;
     oldLon = lon;
 
@@ -825,9 +863,6 @@ static void drawCompassNorth(OLEDDisplay *display, int16_t compassX, int16_t com
     drawLine(display, N1, N4);
 }
 
-/// Convert an integer GPS coords to a floating point
-#define DegD(i) (i * 1e-7)
-
 static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
     // We only advance our nodeIndex if the frame # has changed - because
@@ -862,11 +897,14 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
 
     uint32_t agoSecs = sinceLastSeen(node);
     static char lastStr[20];
-    if (agoSecs < 120) // last 2 mins?
+    if (agoSecs < 120) { // last 2 mins?
         snprintf(lastStr, sizeof(lastStr), "%u seconds ago", agoSecs);
-    else if (agoSecs < 120 * 60) // last 2 hrs
+        setFrameExpiry(1000);
+    } else if (agoSecs < 120 * 60) { // last 2 hrs
         snprintf(lastStr, sizeof(lastStr), "%u minutes ago", agoSecs / 60);
-    else {
+        setFrameExpiry((SEC_PER_MIN - (agoSecs % SEC_PER_MIN)) * 1000);
+    } else {
+        setFrameExpiry((SEC_PER_HOUR - (agoSecs % SEC_PER_HOUR)) * 1000);
         // Only show hours ago if it's been less than 6 months. Otherwise, we may have bad
         //   data.
         if ((agoSecs / 60 / 60) < (hours_in_month * 6)) {
@@ -898,15 +936,15 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
 
     if (ourNode && hasValidPosition(ourNode)) {
         const meshtastic_PositionLite &op = ourNode->position;
-        float myHeading = estimatedHeading(DegD(op.latitude_i), DegD(op.longitude_i));
+        float myHeading = estimatedHeading(op.latitude_i, op.longitude_i);
         drawCompassNorth(display, compassX, compassY, myHeading);
 
         if (hasValidPosition(node)) {
             // display direction toward node
             hasNodeHeading = true;
             const meshtastic_PositionLite &p = node->position;
-            float d =
-                GeoCoord::latLongToMeter(DegD(p.latitude_i), DegD(p.longitude_i), DegD(op.latitude_i), DegD(op.longitude_i));
+            GeoRelation relation = geoCache.get(node->num, op.latitude_i, op.longitude_i, p.latitude_i, p.longitude_i);
+            float d = relation.distance;
 
             if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
                 if (d < (2 * MILES_TO_FEET))
@@ -920,8 +958,7 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
                     snprintf(distStr, sizeof(distStr), "%.1f km", d / 1000);
             }
 
-            float bearingToOther =
-                GeoCoord::bearing(DegD(op.latitude_i), DegD(op.longitude_i), DegD(p.latitude_i), DegD(p.longitude_i));
+            float bearingToOther = relation.bearing;
             // If the top of the compass is a static north then bearingToOther can be drawn on the compass directly
             // If the top of the compass is not a static north we need adjust bearingToOther based on heading
             if (!config.display.compass_north_top)
@@ -949,6 +986,7 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
     : concurrency::OSThread("Screen"), address_found(address), model(screenType), geometry(geometry), cmdQueue(32)
 {
     graphics::normalFrames = new FrameCallback[MAX_NUM_NODES + NUM_EXTRA_FRAMES];
+    graphics::normalFrameDependencies = new uint8_t[MAX_NUM_NODES + NUM_EXTRA_FRAMES];
 #if defined(USE_SH1106) || defined(USE_SH1107) || defined(USE_SH1107_128_64)
     dispdev = new SH1106Wire(address.address, -1, -1, geometry,
                              (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
@@ -990,6 +1028,7 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
 Screen::~Screen()
 {
     delete[] graphics::normalFrames;
+    delete[] graphics::normalFrameDependencies;
 }
 
 /**
@@ -1025,6 +1064,7 @@ void Screen::handleSetOn(bool on, FrameCallback einkScreensaver)
 #endif
             dispdev->displayOn();
             enabled = true;
+            invalidateFrames();
             setInterval(0); // Draw ASAP
             runASAP = true;
         } else {
@@ -1288,7 +1328,20 @@ int32_t Screen::runOnce()
 
     // this must be before the frameState == FIXED check, because we always
     // want to draw at least one FIXED frame before doing forceDisplay
-    ui->update();
+    // If nothing shown by the current frame has changed, skip both the draw and the push to the display
+    if (isFrameDirty()) {
+        unsigned long lastUpdate = ui->getUiState()->lastUpdate;
+        uint32_t lastExpiry = frameExpiresMs;
+        frameExpiresMs = millis(); // Frame may extend this while drawing
+
+        ui->update();
+
+        // UI is rate-limited, so may not have drawn this time
+        if (ui->getUiState()->lastUpdate != lastUpdate)
+            dirtyDependencies = DEPENDS_NONE;
+        else
+            frameExpiresMs = lastExpiry;
+    }
 
     // Switch to a low framerate (to save CPU) when we are not in transition
     // but we should only call setTargetFPS when framestate changes, because
@@ -1320,6 +1373,27 @@ int32_t Screen::runOnce()
     return (1000 / targetFramerate);
 }
 
+bool Screen::isFrameDirty()
+{
+    // Boot screen, alerts, and transitions are always drawn
+    if (!showingNormalScreen || targetFramerate != IDLE_FRAMERATE || ui->getUiState()->frameState != FIXED)
+        return true;
+
+    uint8_t frame = ui->getUiState()->currentFrame;
+    if (frame >= numNormalFrames)
+        return true;
+
+    uint8_t dependencies = normalFrameDependencies[frame];
+    if (dependencies & dirtyDependencies)
+        return true;
+
+    // Content changes with time, and what we last drew is now out of date
+    if ((dependencies & DEPENDS_CLOCK) && (int32_t)(millis() - frameExpiresMs) >= 0)
+        return true;
+
+    return false;
+}
+
 void Screen::drawDebugInfoTrampoline(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
     Screen *screen2 = reinterpret_cast<Screen *>(state->userData);
@@ -1438,6 +1512,12 @@ void Screen::setFrames()
 
     size_t numframes = 0;
 
+    // Add a frame, recording which data it displays
+    auto addFrame = [&numframes](FrameCallback frame, uint8_t dependencies) {
+        normalFrameDependencies[numframes] = dependencies;
+        normalFrames[numframes++] = frame;
+    };
+
     // put all of the module frames first.
     // this is a little bit of a dirty hack; since we're going to call
     // the same drawModuleFrame handler here for all of these module frames
@@ -1445,43 +1525,46 @@ void Screen::setFrames()
     // is the same offset into the moduleFrames vector
     // so that we can invoke the module's callback
     for (auto i = moduleFrames.begin(); i != moduleFrames.end(); ++i) {
-        normalFrames[numframes++] = drawModuleFrame;
+        addFrame(drawModuleFrame, DEPENDS_CLOCK); // Module frames can show anything
     }
 
     LOG_DEBUG("Added modules.  numframes: %d\n", numframes);
 
     // If we have a critical fault, show it first
     if (error_code)
-        normalFrames[numframes++] = drawCriticalFaultFrame;
+        addFrame(drawCriticalFaultFrame, DEPENDS_NONE);
 
     // If we have a text message - show it next, unless it's a phone message and we aren't using any special modules
     if (devicestate.has_rx_text_message && shouldDrawMessage(&devicestate.rx_text_message)) {
-        normalFrames[numframes++] = drawTextMessageFrame;
+        addFrame(drawTextMessageFrame, DEPENDS_NODE_STATUS | DEPENDS_CLOCK);
     }
     // If we have a waypoint - show it next, unless it's a phone message and we aren't using any special modules
     if (devicestate.has_rx_waypoint && shouldDrawMessage(&devicestate.rx_waypoint)) {
-        normalFrames[numframes++] = drawWaypointFrame;
+        addFrame(drawWaypointFrame, DEPENDS_NODE_STATUS | DEPENDS_CLOCK);
     }
 
     // then all the nodes
     // We only show a few nodes in our scrolling list - because meshes with many nodes would have too many screens
     size_t numToShow = min(numMeshNodes, 4U);
     for (size_t i = 0; i < numToShow; i++)
-        normalFrames[numframes++] = drawNodeInfo;
+        addFrame(drawNodeInfo, DEPENDS_CURRENT_NODE | DEPENDS_GPS_STATUS | DEPENDS_CLOCK);
 
     // then the debug info
     //
     // Since frames are basic function pointers, we have to use a helper to
     // call a method on debugInfo object.
-    normalFrames[numframes++] = &Screen::drawDebugInfoTrampoline;
+    uint8_t debugDependencies = DEPENDS_NODE_STATUS | DEPENDS_GPS_STATUS | DEPENDS_POWER_STATUS | DEPENDS_LOG;
+    if (moduleConfig.store_forward.enabled)
+        debugDependencies |= DEPENDS_CLOCK; // Store & Forward heartbeat indicator
+    addFrame(&Screen::drawDebugInfoTrampoline, debugDependencies);
 
     // call a method on debugInfoScreen object (for more details)
-    normalFrames[numframes++] = &Screen::drawDebugInfoSettingsTrampoline;
+    addFrame(&Screen::drawDebugInfoSettingsTrampoline, DEPENDS_GPS_STATUS | DEPENDS_POWER_STATUS | DEPENDS_CLOCK);
 
 #if HAS_WIFI && !defined(ARCH_PORTDUINO)
     if (isWifiAvailable()) {
         // call a method on debugInfoScreen object (for more details)
-        normalFrames[numframes++] = &Screen::drawDebugInfoWiFiTrampoline;
+        addFrame(&Screen::drawDebugInfoWiFiTrampoline, DEPENDS_CLOCK);
     }
 #endif
 
@@ -1489,6 +1572,7 @@ void Screen::setFrames()
 
     ui->setFrames(normalFrames, numframes);
     ui->enableAllIndicators();
+    numNormalFrames = numframes;
 
     prevFrame = -1; // Force drawNodeInfo to pick a new node (because our list
                     // just changed)
@@ -1602,6 +1686,7 @@ void Screen::handlePrint(const char *text)
         return;
 
     dispdev->print(text);
+    invalidateFrames(DEPENDS_LOG);
 }
 
 void Screen::handleOnPress()
@@ -1645,6 +1730,7 @@ void Screen::setFastFramerate()
 {
     // We are about to start a transition so speed up fps
     targetFramerate = SCREEN_TRANSITION_FRAMERATE;
+    invalidateFrames();
 
     ui->setTargetFPS(targetFramerate);
     setInterval(0); // redraw ASAP
@@ -1949,8 +2035,19 @@ int Screen::handleStatusUpdate(const meshtastic::Status *arg)
         if (showingNormalScreen && nodeStatus->getLastNumTotal() != nodeStatus->getNumTotal()) {
             setFrames(); // Regen the list of screens
         }
+        invalidateFrames(DEPENDS_NODE_STATUS);
+        // Only redraw a node info frame if it is showing the node that changed (or our own node, for distance and heading)
+        if (nodeDB->updateGUIforNode && (nodeDB->updateGUIforNode == nodeDB->getMeshNodeByIndex(nodeIndex) ||
+                                         nodeDB->updateGUIforNode->num == nodeDB->getNodeNum()))
+            invalidateFrames(DEPENDS_CURRENT_NODE);
         nodeDB->updateGUI = false;
         break;
+    case STATUS_TYPE_GPS:
+        invalidateFrames(DEPENDS_GPS_STATUS);
+        break;
+    case STATUS_TYPE_POWER:
+        invalidateFrames(DEPENDS_POWER_STATUS);
+        break;
     }
 
     return 0;
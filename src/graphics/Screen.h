@@ -161,6 +161,21 @@ class Screen : public concurrency::OSThread
 
     void blink();
 
+    /// Data which a frame displays. A frame is only redrawn when one of its dependencies has changed
+    enum FrameDependency : uint8_t {
+        DEPENDS_NONE = 0,
+        DEPENDS_NODE_STATUS = (1 << 0),  // Node counts, or any node's info in NodeDB
+        DEPENDS_CURRENT_NODE = (1 << 1), // The node shown by a node info frame, or our own node
+        DEPENDS_GPS_STATUS = (1 << 2),   // GPS lock and our position
+        DEPENDS_POWER_STATUS = (1 << 3), // Battery and USB
+        DEPENDS_LOG = (1 << 4),          // Log buffer, written by print()
+        DEPENDS_CLOCK = (1 << 5),        // Changes with time. Redrawn every idle frame, unless setFrameExpiry() was called
+        DEPENDS_ALL = 0xFF,
+    };
+
+    /// Mark any frames which display this data as needing a redraw
+    void invalidateFrames(uint8_t dependencies = DEPENDS_ALL) { dirtyDependencies |= dependencies; }
+
     /// Handle button press, trackball or swipe action)
     void onPress() { enqueueCmd(ScreenCmd{.cmd = Cmd::ON_PRESS}); }
     void showPrevFrame() { enqueueCmd(ScreenCmd{.cmd = Cmd::SHOW_PREV_FRAME}); }
@@ -375,6 +390,9 @@ class Screen : public concurrency::OSThread
     /// Try to start drawing ASAP
     void setFastFramerate();
 
+    /// Has the data shown by the current frame changed since it was last drawn?
+    bool isFrameDirty();
+
     // Sets frame up for immediate drawing
     void setFrameImmediateDraw(FrameCallback *drawFrames);
 
@@ -394,6 +412,8 @@ class Screen : public concurrency::OSThread
     // Whether we are showing the regular screen (as opposed to booth screen or
     // Bluetooth PIN screen)
     bool showingNormalScreen = false;
+    /// Dependencies which have changed since the last frame was drawn (FrameDependency flags)
+    uint8_t dirtyDependencies = DEPENDS_ALL;
 
     /// Holds state for debug information
     DebugInfo debugInfo;
@@ -82,6 +82,7 @@ NRF52Bluetooth *nrf52Bluetooth;
 #ifdef ARCH_PORTDUINO
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
+#include "platform/portduino/Benchmark.h"
 #include "platform/portduino/PortduinoGlue.h"
 #include <fstream>
 #include <iostream>
@@ -954,6 +955,13 @@ void setup()
     PowerFSM_setup(); // we will transition to ON in a couple of seconds, FIXME, only do this for cold boots, not waking from SDS
     powerFSMthread = new PowerFSMThread();
     setCPUFast(false); // 80MHz is fine for our slow peripherals
+
+#ifdef ARCH_PORTDUINO
+    if (benchmarkRequested) {
+        runBenchmarks();
+        exit(EXIT_SUCCESS);
+    }
+#endif
 }
 
 uint32_t rebootAtMsec;   // If not zero we will reboot at this time (used to reboot shortly after the update completes)
@@ -1,5 +1,7 @@
 #include "FloodingRouter.h"
+#include "NodeDB.h"
 #include "configuration.h"
+#include "gps/GeoCoord.h"
 #include "mesh-pb-constants.h"
 
 FloodingRouter::FloodingRouter() {}
@@ -20,19 +22,57 @@ ErrorCode FloodingRouter::send(meshtastic_MeshPacket *p)
 bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
 {
     if (wasSeenRecently(p)) { // Note: this will also add a recent packet record
-        printPacket("Ignoring incoming msg, because we've already seen it", p);
-        if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
-            config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_CLIENT &&
-            config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
-            // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
-            Router::cancelSending(p->from, p->id);
-        }
+        handleDuplicate(p);
         return true;
     }
 
     return Router::shouldFilterReceived(p);
 }
 
+bool FloodingRouter::shouldDropDuplicate(const meshtastic_MeshPacket *p)
+{
+    // Don't add a record for packets we haven't seen, shouldFilterReceived() still has to find them new
+    if (!wasSeenRecently(p, false))
+        return false;
+
+    wasSeenRecently(p); // Refresh the record, as shouldFilterReceived() would have
+    handleDuplicate(p);
+    return true;
+}
+
+void FloodingRouter::handleDuplicate(const meshtastic_MeshPacket *p)
+{
+    printPacket("Ignoring incoming msg, because we've already seen it", p);
+    floodStats.duplicates++;
+
+    PendingFlood *f = findPendingFlood(p);
+    if (f) {
+        f->timesHeard++;
+        f->uncovered *= uncoveredBy(p);
+    }
+
+    if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_CLIENT &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
+        // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
+        if (Router::cancelSending(p->from, p->id))
+            floodStats.cancelledDuplicate++;
+    } else if (f && FLOOD_SUPPRESS_COUNT && f->timesHeard >= FLOOD_SUPPRESS_COUNT) {
+        // Routers still drop it once enough others have rebroadcast it, or those that did cover nearly all our range
+        if (Router::cancelSending(p->from, p->id)) {
+            LOG_DEBUG("Suppressing rebroadcast, heard it %d times\n", f->timesHeard);
+            floodStats.suppressedCount++;
+        }
+        f->from = 0;
+    } else if (f && f->uncovered < FLOOD_MIN_EXTRA_COVERAGE) {
+        if (Router::cancelSending(p->from, p->id)) {
+            LOG_DEBUG("Suppressing rebroadcast, it would only reach %d%% more of our range\n", (int)(f->uncovered * 100));
+            floodStats.suppressedCoverage++;
+        }
+        f->from = 0;
+    }
+}
+
 void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c)
 {
     bool isAck =
@@ -42,7 +82,7 @@ void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
         LOG_DEBUG("Receiving an ACK not for me, but don't need to rebroadcast this direct message anymore.\n");
         Router::cancelSending(p->to, p->decoded.request_id); // cancel rebroadcast for this DM
     }
-    if ((p->to != getNodeNum()) && (p->hop_limit > 0) && (getFrom(p) != getNodeNum())) {
+    if ((p->to != getNodeNum()) && (p->hop_limit > 0) && (getFrom(p) != getNodeNum()) && shouldRelay(p)) {
         if (p->id != 0) {
             if (config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE) {
                 meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
@@ -50,6 +90,11 @@ void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
                 tosend->hop_limit--; // bump down the hop count
 
                 LOG_INFO("Rebroadcasting received floodmsg to neighbors\n");
+                // Remember it, so we can count the copies of it we hear before ours goes out
+                pendingFloods[nextPendingFlood] = {p->from, p->id, 1, uncoveredBy(p)};
+                nextPendingFlood = (nextPendingFlood + 1) % MAX_TX_QUEUE;
+                floodStats.rebroadcasts++;
+
                 // Note: we are careful to resend using the original senders node id
                 // We are careful not to call our hooked version of send() - because we don't want to check this again
                 Router::send(tosend);
@@ -62,4 +107,38 @@ void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
     }
     // handle the packet as normal
     Router::sniffReceived(p, c);
-}
\ No newline at end of file
+}
+
+FloodingRouter::PendingFlood *FloodingRouter::findPendingFlood(const meshtastic_MeshPacket *p)
+{
+    for (PendingFlood &f : pendingFloods) {
+        if (f.from == p->from && f.id == p->id)
+            return &f;
+    }
+    return NULL;
+}
+
+float FloodingRouter::uncoveredBy(const meshtastic_MeshPacket *p)
+{
+    if (p->via_mqtt)
+        return 1; // Didn't cover anything on our radio
+
+    // How far away the transmitter is, as a share of our range
+    float x = (FLOOD_SNR_NEAR - p->rx_snr) / (FLOOD_SNR_NEAR - FLOOD_SNR_FAR);
+#if FLOOD_COVERAGE_RANGE_METERS > 0
+    // If it wasn't relayed, its sender transmitted it, and we might know where they are
+    if (p->hop_start != 0 && p->hop_start == p->hop_limit) {
+        const meshtastic_NodeInfoLite *them = nodeDB->getMeshNode(p->from);
+        const meshtastic_NodeInfoLite *us = nodeDB->getMeshNode(getNodeNum());
+        if (them && us && hasValidPosition(them) && hasValidPosition(us))
+            x = GeoCoord::latLongToMeterFast(them->position.latitude_i, them->position.longitude_i, us->position.latitude_i,
+                                             us->position.longitude_i) /
+                FLOOD_COVERAGE_RANGE_METERS;
+    }
+#endif
+    x = constrain(x, 0.0f, 1.0f);
+
+    // The share of our coverage circle that an equal circle x ranges away overlaps
+    float overlap = (2 * acosf(x / 2) - (x / 2) * sqrtf(4 - x * x)) / (float)PI;
+    return 1 - overlap;
+}
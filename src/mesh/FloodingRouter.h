@@ -3,6 +3,39 @@
 #include "PacketHistory.h"
 #include "Router.h"
 
+/// A router that hears a packet this many times (the original included) before its own rebroadcast goes out drops that
+/// rebroadcast. 0 to never do so. Other roles already drop theirs on hearing the first rebroadcast
+#ifndef FLOOD_SUPPRESS_COUNT
+#define FLOOD_SUPPRESS_COUNT 3
+#endif
+
+/// A router also drops its rebroadcast once the share of its range that the copies it heard don't cover falls below this
+#ifndef FLOOD_MIN_EXTRA_COVERAGE
+#define FLOOD_MIN_EXTRA_COVERAGE 0.2f
+#endif
+
+/// SNRs at which we take a transmitter to be right next to us, and at the edge of our range
+#ifndef FLOOD_SNR_NEAR
+#define FLOOD_SNR_NEAR 10.0f
+#endif
+#ifndef FLOOD_SNR_FAR
+#define FLOOD_SNR_FAR -15.0f
+#endif
+
+/// Our range, to estimate coverage from positions where we know them. 0 to only go by SNR
+#ifndef FLOOD_COVERAGE_RANGE_METERS
+#define FLOOD_COVERAGE_RANGE_METERS 0
+#endif
+
+/// What happened to the packets we could have rebroadcast
+struct FloodStats {
+    uint32_t rebroadcasts;       // Rebroadcasts we queued
+    uint32_t duplicates;         // Copies we heard of packets we had already seen
+    uint32_t cancelledDuplicate; // Rebroadcasts dropped because someone else rebroadcast first
+    uint32_t suppressedCount;    // Rebroadcasts dropped by a router after hearing FLOOD_SUPPRESS_COUNT copies
+    uint32_t suppressedCoverage; // Rebroadcasts dropped by a router because they wouldn't reach much new ground
+};
+
 /**
  * This is a mixin that extends Router with the ability to do Naive Flooding (in the standard mesh protocol sense)
  *
@@ -43,6 +76,8 @@ class FloodingRouter : public Router, protected PacketHistory
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    virtual const FloodStats *getFloodStats() const override { return &floodStats; }
+
   protected:
     /**
      * Should this incoming filter be dropped?
@@ -52,8 +87,38 @@ class FloodingRouter : public Router, protected PacketHistory
      */
     virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) override;
 
+    /// Drop copies of packets we have already seen straight from their header
+    virtual bool shouldDropDuplicate(const meshtastic_MeshPacket *p) override;
+
+    /**
+     * Should we be one of the nodes rebroadcasting this packet? Plain flooding rebroadcasts everything
+     */
+    virtual bool shouldRelay(const meshtastic_MeshPacket *p) { return true; }
+
     /**
      * Look for broadcasts we need to rebroadcast
      */
     virtual void sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c) override;
+
+  private:
+    /// A rebroadcast we have queued, and the copies of it we have heard since
+    struct PendingFlood {
+        NodeNum from;
+        PacketId id;
+        uint8_t timesHeard;
+        float uncovered; // Share of our range none of those copies reached
+    };
+
+    PendingFlood pendingFloods[MAX_TX_QUEUE] = {};
+    uint8_t nextPendingFlood = 0;
+
+    FloodStats floodStats = {};
+
+    PendingFlood *findPendingFlood(const meshtastic_MeshPacket *p);
+
+    /// Count a copy of a packet we have already seen, and cancel our own rebroadcast of it if it's no longer needed
+    void handleDuplicate(const meshtastic_MeshPacket *p);
+
+    /// The share of our range that the transmission we heard p from did not reach
+    float uncoveredBy(const meshtastic_MeshPacket *p);
 };
\ No newline at end of file
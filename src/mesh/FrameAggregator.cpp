@@ -0,0 +1,105 @@
+#include "FrameAggregator.h"
+#include "NodeDB.h"
+#include "configuration.h"
+
+static const uint8_t AGGREGATE_MAGIC[2] = {'A', 'G'};
+#define AGGREGATE_VERSION 1
+
+/// How long neighborsCapable() reuses its answer
+#define NEIGHBOR_CHECK_MSEC (60 * 1000UL)
+
+bool FrameAggregator::isAggregate(const uint8_t *frame, size_t len)
+{
+    const PacketHeader *h = (const PacketHeader *)frame;
+    const AggregateHeader *a = (const AggregateHeader *)(frame + sizeof(PacketHeader));
+    return len >= sizeof(PacketHeader) + sizeof(AggregateHeader) && h->id == 0 && h->to == NODENUM_BROADCAST &&
+           a->magic[0] == AGGREGATE_MAGIC[0] && a->magic[1] == AGGREGATE_MAGIC[1] && a->version == AGGREGATE_VERSION;
+}
+
+bool FrameAggregator::next(const uint8_t *frame, size_t len, size_t &offset, const uint8_t *&packet, size_t &packetLen)
+{
+    if (offset == 0)
+        offset = sizeof(PacketHeader) + sizeof(AggregateHeader);
+    if (offset >= len)
+        return false;
+
+    packetLen = frame[offset];
+    if (packetLen < sizeof(PacketHeader) || offset + 1 + packetLen > len)
+        return false;
+
+    packet = frame + offset + 1;
+    offset += 1 + packetLen;
+    return true;
+}
+
+size_t FrameAggregator::begin(uint8_t *frame, NodeNum from)
+{
+    PacketHeader *h = (PacketHeader *)frame;
+    memset(h, 0, sizeof(*h));
+    h->from = from;
+    h->to = NODENUM_BROADCAST;
+    h->next_hop = NO_NEXT_HOP;
+    h->relay_node = (uint8_t)from;
+
+    AggregateHeader *a = (AggregateHeader *)(frame + sizeof(PacketHeader));
+    a->magic[0] = AGGREGATE_MAGIC[0];
+    a->magic[1] = AGGREGATE_MAGIC[1];
+    a->version = AGGREGATE_VERSION;
+    a->count = 0;
+    return sizeof(PacketHeader) + sizeof(AggregateHeader);
+}
+
+size_t FrameAggregator::spaceLeft(const uint8_t *frame, size_t len) const
+{
+    const AggregateHeader *a = (const AggregateHeader *)(frame + sizeof(PacketHeader));
+    if (a->count >= FRAME_AGGREGATION_MAX_PACKETS || len + 1 >= FRAME_AGGREGATION_MAX_LEN)
+        return 0;
+    return FRAME_AGGREGATION_MAX_LEN - len - 1; // Each packet is prefixed by its length
+}
+
+void FrameAggregator::add(uint8_t *frame, size_t &len, const uint8_t *packet, size_t packetLen)
+{
+    assert(fits(frame, len, packetLen));
+    AggregateHeader *a = (AggregateHeader *)(frame + sizeof(PacketHeader));
+    a->count++;
+    frame[len] = packetLen;
+    memcpy(frame + len + 1, packet, packetLen);
+    len += 1 + packetLen;
+}
+
+bool FrameAggregator::isCapable(NodeNum n, uint32_t now) const
+{
+    auto found = capable.find(n);
+    return found != capable.end() && now - found->second < FRAME_AGGREGATION_CAPABLE_MSEC;
+}
+
+bool FrameAggregator::neighborsCapable()
+{
+    uint32_t now = millis();
+    if (neighborsCheckedMsec && now - neighborsCheckedMsec < NEIGHBOR_CHECK_MSEC)
+        return neighborsWereCapable;
+    neighborsCheckedMsec = now;
+
+    // Nodes we have no hop count for also show up as 0 hops away, which errs on the side of not bundling
+    size_t neighbors = 0;
+    bool allCapable = true;
+    for (size_t i = 0; i < nodeDB->getNumMeshNodes() && allCapable; i++) {
+        const meshtastic_NodeInfoLite *n = nodeDB->getMeshNodeByIndex(i);
+        if (n->num == nodeDB->getNodeNum() || n->via_mqtt || n->hops_away != 0 ||
+            sinceLastSeen(n) > FRAME_AGGREGATION_NEIGHBOR_SECS)
+            continue;
+        neighbors++;
+        allCapable = isCapable(n->num, now);
+    }
+
+    // Forget the hellos of nodes that have gone quiet
+    for (auto i = capable.begin(); i != capable.end();) {
+        if (now - i->second >= FRAME_AGGREGATION_CAPABLE_MSEC)
+            i = capable.erase(i);
+        else
+            ++i;
+    }
+
+    neighborsWereCapable = neighbors > 0 && allCapable;
+    return neighborsWereCapable;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "RadioInterface.h"
+#include <unordered_map>
+
+/// Bundle small packets of ours into one LoRa frame, once all our neighbors have told us they can unbundle them
+#ifndef FRAME_AGGREGATION
+#define FRAME_AGGREGATION 0
+#endif
+
+/// How often we tell our neighbors that we can unbundle frames, and how long we trust theirs
+#ifndef FRAME_AGGREGATION_HELLO_MSEC
+#define FRAME_AGGREGATION_HELLO_MSEC (15 * 60 * 1000UL)
+#endif
+#define FRAME_AGGREGATION_CAPABLE_MSEC (3 * FRAME_AGGREGATION_HELLO_MSEC)
+
+/// Nodes we heard directly within this long are the neighbors that have to be able to unbundle
+#ifndef FRAME_AGGREGATION_NEIGHBOR_SECS
+#define FRAME_AGGREGATION_NEIGHBOR_SECS (2 * 60 * 60)
+#endif
+
+/// Most packets in one frame
+#define FRAME_AGGREGATION_MAX_PACKETS 8
+
+/// Longest frame LoRa can carry. MAX_RHPACKETLEN is one more than that
+#define FRAME_AGGREGATION_MAX_LEN 255
+
+/**
+ * Several packets (each with its own PacketHeader and encrypted payload) in one LoRa frame, so they share one preamble.
+ *
+ * The frame has a PacketHeader of its own, from the sender to broadcast with id 0 and a hop limit of 0, so older firmware
+ * neither rebroadcasts it nor remembers it. Then comes an AggregateHeader, and each packet prefixed by its length.
+ * A frame without any packets is our hello, telling neighbors that we can unbundle. Nodes built with FRAME_AGGREGATION
+ * send one every FRAME_AGGREGATION_HELLO_MSEC. Other nodes only answer the hellos and bundles they hear, at most once per
+ * FRAME_AGGREGATION_HELLO_MSEC, so a mesh without bundling nodes doesn't carry any hellos at all.
+ *
+ * Older firmware can't unbundle, so we only bundle while every neighbor we heard recently has sent us a hello.
+ */
+class FrameAggregator
+{
+  public:
+    /// Is this frame a bundle (or hello) rather than a single packet?
+    static bool isAggregate(const uint8_t *frame, size_t len);
+
+    /**
+     * Step through the packets in a bundle. Start with offset 0.
+     * @return false once there are no more (or the rest of the frame is corrupt)
+     */
+    static bool next(const uint8_t *frame, size_t len, size_t &offset, const uint8_t *&packet, size_t &packetLen);
+
+    /// Start a bundle (or hello) from us in frame, returns its length so far
+    size_t begin(uint8_t *frame, NodeNum from);
+
+    /// The longest packet that still fits in a bundle this long, 0 if it is full
+    size_t spaceLeft(const uint8_t *frame, size_t len) const;
+
+    /// Would a packet this long still fit in a bundle this long?
+    bool fits(const uint8_t *frame, size_t len, size_t packetLen) const { return packetLen <= spaceLeft(frame, len); }
+
+    /// Append a packet (PacketHeader and payload) to a bundle
+    void add(uint8_t *frame, size_t &len, const uint8_t *packet, size_t packetLen);
+
+    /// Remember that a node can unbundle, because we heard a bundle or hello from it. We owe it a hello in return
+    void noteCapable(NodeNum n)
+    {
+        capable[n] = millis();
+        helloOwed = true;
+    }
+
+    /// Is it time for our next hello? Only nodes that bundle send them unasked
+    bool helloDue() const
+    {
+        return (FRAME_AGGREGATION || helloOwed) && (!lastHelloMsec || millis() - lastHelloMsec >= FRAME_AGGREGATION_HELLO_MSEC);
+    }
+
+    /// Our hello (or a bundle, which says as much) went out, or we skipped it: the next one is due in a full period
+    void noteHelloSent()
+    {
+        lastHelloMsec = millis();
+        helloOwed = false;
+    }
+
+    /// Can every neighbor we heard recently unbundle?
+    bool neighborsCapable();
+
+  private:
+    struct AggregateHeader {
+        uint8_t magic[2];
+        uint8_t version;
+        uint8_t count;
+    };
+
+    std::unordered_map<NodeNum, uint32_t> capable; // When we last heard a bundle or hello from each node
+
+    uint32_t lastHelloMsec = 0;
+    bool helloOwed = false; // We heard from a node that can unbundle since our last hello
+
+    bool neighborsWereCapable = false; // Cached answer of neighborsCapable(), it walks the whole NodeDB
+    uint32_t neighborsCheckedMsec = 0;
+
+    bool isCapable(NodeNum n, uint32_t now) const;
+};
@@ -0,0 +1,44 @@
+#include "HopLimitOptimizer.h"
+#include "configuration.h"
+
+void HopLimitOptimizer::noteHops(NodeNum n, uint8_t hops)
+{
+    if (n == NODENUM_BROADCAST || hops > HOP_MAX)
+        return;
+
+    uint32_t now = millis();
+    auto found = distances.find(n);
+    if (found != distances.end()) {
+        Distance &d = found->second;
+        // Copies that took a longer way arrive all the time, only believe a longer distance once the shorter one is stale
+        if (hops <= d.hops || now - d.heardMsec >= HOP_LIMIT_DECAY_MSEC)
+            d = {hops, now};
+        return;
+    }
+
+    if (distances.size() >= HOP_LIMIT_MAX_NODES) {
+        auto oldest = distances.begin();
+        for (auto i = distances.begin(); i != distances.end(); ++i)
+            if (now - i->second.heardMsec > now - oldest->second.heardMsec)
+                oldest = i;
+        distances.erase(oldest);
+    }
+    distances[n] = {hops, now};
+}
+
+uint8_t HopLimitOptimizer::getHopLimit(NodeNum dest, uint8_t hopLimit) const
+{
+    if (!HOP_LIMIT_TRIMMING || dest == NODENUM_BROADCAST || hopLimit == 0)
+        return hopLimit;
+
+    auto found = distances.find(dest);
+    if (found == distances.end())
+        return hopLimit;
+
+    uint32_t age = millis() - found->second.heardMsec;
+    if (age >= HOP_LIMIT_TIMEOUT_MSEC)
+        return hopLimit;
+
+    uint32_t needed = found->second.hops + HOP_LIMIT_MARGIN + age / HOP_LIMIT_DECAY_MSEC;
+    return needed < hopLimit ? needed : hopLimit;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <unordered_map>
+
+/// Start our own DMs with just enough hops to reach a destination we know the distance of
+#ifndef HOP_LIMIT_TRIMMING
+#define HOP_LIMIT_TRIMMING 1
+#endif
+
+/// Hops we add on top of the distance we learned, as the way there may be longer than the way back
+#ifndef HOP_LIMIT_MARGIN
+#define HOP_LIMIT_MARGIN 1
+#endif
+
+/// One more hop of margin for each this long since we learned a distance
+#ifndef HOP_LIMIT_DECAY_MSEC
+#define HOP_LIMIT_DECAY_MSEC (30 * 60 * 1000UL)
+#endif
+
+/// How long a learned distance is used at all
+#ifndef HOP_LIMIT_TIMEOUT_MSEC
+#define HOP_LIMIT_TIMEOUT_MSEC (2 * 60 * 60 * 1000UL)
+#endif
+
+/// How many distances we remember, the least recently heard are forgotten first
+#ifndef HOP_LIMIT_MAX_NODES
+#define HOP_LIMIT_MAX_NODES 64
+#endif
+
+/**
+ * Learns how many hops away other nodes are, and picks the smallest hop limit that still reaches them.
+ *
+ * The configured hop limit is sized for the far side of the mesh, so every DM to a neighbor would otherwise be relayed
+ * through all of it. Distances come from the hop start and hop limit of every packet we hear (duplicates included, as
+ * those may have taken a shorter way), from NeighborInfo and from traceroute responses.
+ */
+class HopLimitOptimizer
+{
+  public:
+    /// n is hops hops away (0 if we hear it directly)
+    void noteHops(NodeNum n, uint8_t hops);
+
+    /// A packet to n wasn't acked, use the configured hop limit until we hear from it again
+    void noteFailure(NodeNum n) { distances.erase(n); }
+
+    /// The hop limit to use instead of hopLimit for a packet we originate to dest. Never more than hopLimit
+    uint8_t getHopLimit(NodeNum dest, uint8_t hopLimit) const;
+
+  private:
+    struct Distance {
+        uint8_t hops;
+        uint32_t heardMsec;
+    };
+
+    std::unordered_map<NodeNum, Distance> distances;
+};
@@ -100,6 +100,23 @@ meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id)
     return NULL;
 }
 
+meshtastic_MeshPacket *MeshPacketQueue::dequeueFrom(NodeNum from, size_t maxSize)
+{
+    auto best = queue.end();
+    for (auto it = queue.begin(); it != queue.end(); it++) {
+        auto p = (*it);
+        if (getFrom(p) == from && p->encrypted.size <= maxSize && (best == queue.end() || CompareMeshPacketFunc(*best, p)))
+            best = it;
+    }
+    if (best == queue.end())
+        return NULL;
+
+    auto p = (*best);
+    queue.erase(best);
+    std::make_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc);
+    return p;
+}
+
 /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
 bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 {
@@ -37,4 +37,7 @@ class MeshPacketQueue
 
     /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
     meshtastic_MeshPacket *remove(NodeNum from, PacketId id);
+
+    /** Remove the highest priority packet from 'from' whose encrypted payload is at most maxSize bytes, NULL if there is none */
+    meshtastic_MeshPacket *dequeueFrom(NodeNum from, size_t maxSize);
 };
@@ -0,0 +1,149 @@
+#include "NextHopRouter.h"
+#include "NodeDB.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+
+uint8_t NextHopRouter::getNextHop(const meshtastic_MeshPacket *p)
+{
+#if NEXT_HOP_ROUTING
+    // Only DMs that will be retransmitted (and so flooded) if the relay lets us down
+    if (p->to == NODENUM_BROADCAST || !p->want_ack || p->via_mqtt)
+        return NO_NEXT_HOP;
+
+    for (const FloodedPacket &f : flooded) {
+        if (f.from == getFrom(p) && f.id == p->id)
+            return NO_NEXT_HOP;
+    }
+
+    // A relay of a flooded packet keeps it flooded, so a route that broke further along isn't tried again
+    if (getFrom(p) != getNodeNum()) {
+        bool routed = false;
+        for (const FloodedPacket &r : routedToUs)
+            routed |= (r.from == p->from && r.id == p->id);
+        if (!routed)
+            return NO_NEXT_HOP;
+    }
+
+    auto found = routes.find(p->to);
+    if (found == routes.end())
+        return NO_NEXT_HOP;
+    if (millis() - found->second.updatedMsec > NEXT_HOP_ROUTE_TIMEOUT_MSEC) {
+        routes.erase(found);
+        return NO_NEXT_HOP;
+    }
+    return found->second.relay;
+#else
+    return NO_NEXT_HOP;
+#endif
+}
+
+void NextHopRouter::sniffRelayHeader(const meshtastic_MeshPacket *p, uint8_t nextHop, uint8_t relayNode)
+{
+    headers[nextHeader] = {p, p->from, p->id, nextHop, relayNode};
+    nextHeader = (nextHeader + 1) % NEXT_HOP_HEADER_CACHE;
+}
+
+const NextHopRouter::RelayHeader *NextHopRouter::findRelayHeader(const meshtastic_MeshPacket *p) const
+{
+    // Newest first, a recycled packet buffer can hold another copy of the same packet
+    for (uint8_t i = 1; i <= NEXT_HOP_HEADER_CACHE; i++) {
+        const RelayHeader &h = headers[(nextHeader + NEXT_HOP_HEADER_CACHE - i) % NEXT_HOP_HEADER_CACHE];
+        if (h.packet == p && h.from == p->from && h.id == p->id)
+            return &h;
+    }
+    return NULL; // Not from our radio
+}
+
+void NextHopRouter::learnNextHop(NodeNum dest, NodeNum relay, uint8_t hopsAway, float snr)
+{
+    Router::learnNextHop(dest, relay, hopsAway, snr);
+    if (dest == getNodeNum() || relay == getNodeNum() || (uint8_t)relay == NO_NEXT_HOP)
+        return;
+    updateRoute(dest, (uint8_t)relay, hopsAway, snr);
+}
+
+bool NextHopRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
+{
+    learnRoute(p);
+    return FloodingRouter::shouldFilterReceived(p);
+}
+
+bool NextHopRouter::shouldDropDuplicate(const meshtastic_MeshPacket *p)
+{
+    if (!FloodingRouter::shouldDropDuplicate(p))
+        return false; // shouldFilterReceived() will learn from it
+
+    learnRoute(p);
+    return true;
+}
+
+void NextHopRouter::learnRoute(const meshtastic_MeshPacket *p)
+{
+    const RelayHeader *h = findRelayHeader(p);
+    if (h && p->hop_start != 0 && p->hop_limit <= p->hop_start && getFrom(p) != getNodeNum()) {
+        uint8_t hops = p->hop_start - p->hop_limit;
+        // Older firmware leaves relay_node empty, but if it wasn't relayed at all the sender is the relay
+        uint8_t relay = (hops == 0) ? (uint8_t)p->from : h->relayNode;
+        if (relay != NO_NEXT_HOP && relay != ourRelayByte())
+            updateRoute(getFrom(p), relay, hops, p->rx_snr);
+    }
+}
+
+bool NextHopRouter::shouldRelay(const meshtastic_MeshPacket *p)
+{
+    const RelayHeader *h = findRelayHeader(p);
+    if (h && h->nextHop == ourRelayByte() && p->from) {
+        routedToUs[nextRoutedToUs] = {p->from, p->id};
+        nextRoutedToUs = (nextRoutedToUs + 1) % NEXT_HOP_ROUTED_CACHE;
+    }
+    if (!h || h->nextHop == NO_NEXT_HOP || h->nextHop == ourRelayByte())
+        return FloodingRouter::shouldRelay(p);
+
+    LOG_DEBUG("Not rebroadcasting 0x%x, the next hop is 0x%x\n", p->id, h->nextHop);
+    return false;
+}
+
+void NextHopRouter::noteRouteFailure(const meshtastic_MeshPacket *p)
+{
+    flooded[nextFlooded] = {getFrom(p), p->id};
+    nextFlooded = (nextFlooded + 1) % NEXT_HOP_FLOOD_CACHE;
+    hopLimits.noteFailure(p->to); // The retransmission may need every hop it has
+
+    auto found = routes.find(p->to);
+    if (found != routes.end() && ++found->second.failures >= NEXT_HOP_MAX_FAILURES) {
+        LOG_DEBUG("Forgetting the route to 0x%x through 0x%x\n", p->to, found->second.relay);
+        routes.erase(found);
+    }
+}
+
+void NextHopRouter::updateRoute(NodeNum dest, uint8_t relay, uint8_t hops, float snr)
+{
+    uint32_t now = millis();
+
+    auto found = routes.find(dest);
+    if (found != routes.end()) {
+        Route &r = found->second;
+        bool expired = now - r.updatedMsec > NEXT_HOP_ROUTE_TIMEOUT_MSEC;
+        bool better = hops < r.hops || (hops == r.hops && snr > r.snr + NEXT_HOP_SNR_MARGIN);
+        if (r.relay == relay) {
+            r.hops = hops;
+            r.snr = snr;
+            r.failures = 0;
+            r.updatedMsec = now;
+        } else if (expired || better) {
+            r = {relay, hops, 0, snr, now};
+        }
+        return;
+    }
+
+    // Make room by dropping the route we heard from the longest ago
+    if (routes.size() >= nodeDB->getMaxNumNodes()) {
+        auto oldest = routes.begin();
+        for (auto i = routes.begin(); i != routes.end(); ++i) {
+            if (now - i->second.updatedMsec > now - oldest->second.updatedMsec)
+                oldest = i;
+        }
+        routes.erase(oldest);
+    }
+    routes[dest] = {relay, hops, 0, snr, now};
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "FloodingRouter.h"
+#include <unordered_map>
+
+/// Use next hops for want_ack DMs. Without this we only fill in relay_node, so that others can learn routes through us
+#ifndef NEXT_HOP_ROUTING
+#define NEXT_HOP_ROUTING 1
+#endif
+
+/// How long a learned route is used for without hearing from the node through that relay again
+#ifndef NEXT_HOP_ROUTE_TIMEOUT_MSEC
+#define NEXT_HOP_ROUTE_TIMEOUT_MSEC (30 * 60 * 1000UL)
+#endif
+
+/// A route through another relay with as many hops has to be heard this much louder to replace the current one
+#ifndef NEXT_HOP_SNR_MARGIN
+#define NEXT_HOP_SNR_MARGIN 3.0f
+#endif
+
+/// Retransmissions a route may cause before we forget it
+#ifndef NEXT_HOP_MAX_FAILURES
+#define NEXT_HOP_MAX_FAILURES 2
+#endif
+
+/// How many received headers we remember until the router has processed their packet
+#define NEXT_HOP_HEADER_CACHE (2 * 4)
+
+/// How many of our failed packets are flooded on their next retransmission
+#define NEXT_HOP_FLOOD_CACHE 8
+
+/// How many packets that were routed to us we remember until our relay of them goes out
+#define NEXT_HOP_ROUTED_CACHE 8
+
+/**
+ * This is a mixin that extends FloodingRouter with next hop routing of DMs.
+ *
+ * Every node puts the last byte of its NodeNum in the relay_node byte of the header of what it transmits. From overheard
+ * traffic (the relay, hop_start - hop_limit and the SNR) and NeighborInfo packets we learn which neighbor is the best relay
+ * towards each node. A want_ack DM we send, or relay after it was routed to us, then carries the last byte of that neighbor
+ * in next_hop, and the other nodes that hear it don't rebroadcast it. When a retransmission is needed, the packet is
+ * flooded as before, and the relays of a flooded packet keep flooding it.
+ */
+class NextHopRouter : public FloodingRouter
+{
+  public:
+    /// Pick the relay for a packet we are about to transmit
+    virtual uint8_t getNextHop(const meshtastic_MeshPacket *p) override;
+
+    virtual void sniffRelayHeader(const meshtastic_MeshPacket *p, uint8_t nextHop, uint8_t relayNode) override;
+
+    virtual void learnNextHop(NodeNum dest, NodeNum relay, uint8_t hopsAway, float snr) override;
+
+  protected:
+    /// Learn from every copy of a packet we hear, including the duplicates FloodingRouter is about to drop
+    virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) override;
+    virtual bool shouldDropDuplicate(const meshtastic_MeshPacket *p) override;
+
+    /// Only rebroadcast DMs that have no next hop, or that have us as their next hop
+    virtual bool shouldRelay(const meshtastic_MeshPacket *p) override;
+
+    /// One of our packets wasn't acked: flood its retransmission, and forget the route if it keeps failing
+    void noteRouteFailure(const meshtastic_MeshPacket *p);
+
+  private:
+    struct Route {
+        uint8_t relay;        // Last byte of the neighbor to hand packets for this node to
+        uint8_t hops;         // How many hops away the node was, heard through that relay
+        uint8_t failures;     // Retransmissions since we last heard the node through that relay
+        float snr;            // SNR we heard the relay with
+        uint32_t updatedMsec; // When we last heard the node through that relay
+    };
+
+    /// The header bytes of a received packet, until the router gets to it
+    struct RelayHeader {
+        const meshtastic_MeshPacket *packet;
+        NodeNum from;
+        PacketId id;
+        uint8_t nextHop;
+        uint8_t relayNode;
+    };
+
+    struct FloodedPacket {
+        NodeNum from;
+        PacketId id;
+    };
+
+    std::unordered_map<NodeNum, Route> routes;
+
+    RelayHeader headers[NEXT_HOP_HEADER_CACHE] = {};
+    uint8_t nextHeader = 0;
+
+    FloodedPacket flooded[NEXT_HOP_FLOOD_CACHE] = {};
+    uint8_t nextFlooded = 0;
+
+    // Relayed packets that arrived with us as their next hop, the only ones we pass on to a next hop of our own
+    FloodedPacket routedToUs[NEXT_HOP_ROUTED_CACHE] = {};
+    uint8_t nextRoutedToUs = 0;
+
+    const RelayHeader *findRelayHeader(const meshtastic_MeshPacket *p) const;
+
+    /// Learn the route to the sender of a packet from the relay we heard it from
+    void learnRoute(const meshtastic_MeshPacket *p);
+
+    /// Replace the route to dest if this one is fresher, shorter or louder
+    void updateRoute(NodeNum dest, uint8_t relay, uint8_t hops, float snr);
+
+    uint8_t ourRelayByte() { return (uint8_t)getNodeNum(); }
+};
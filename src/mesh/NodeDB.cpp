@@ -95,9 +95,14 @@ uint32_t error_address = 0;
 
 static uint8_t ourMacAddr[6];
 
-NodeDB::NodeDB()
+NodeDB::NodeDB() : concurrency::OSThread("NodeDB")
 {
     LOG_INFO("Initializing NodeDB\n");
+#ifdef ARCH_PORTDUINO
+    // Slots are 16 bit, and one value is reserved for NodeLastHeardList::NONE
+    if (settingsMap[maxnodes] > 0)
+        maxNumNodes = std::min((size_t)settingsMap[maxnodes], (size_t)NodeLastHeardList::NONE);
+#endif
     loadFromDisk();
     cleanupMeshDB();
 
@@ -445,6 +450,9 @@ void NodeDB::installDefaultChannels()
 void NodeDB::resetNodes()
 {
     numMeshNodes = 1;
+    spatialIndex.clear();
+    rebuildSlotIndexes();
+    invalidateOnlineCount();
     std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
     clearLocalPosition();
     saveDeviceStateToDisk();
@@ -464,6 +472,9 @@ void NodeDB::removeNodeByNum(uint nodeNum)
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    spatialIndex.remove(nodeNum);
+    rebuildSlotIndexes();
+    invalidateOnlineCount();
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Saving changes...\n", removed);
     saveDeviceStateToDisk();
 }
@@ -491,6 +502,29 @@ void NodeDB::cleanupMeshDB()
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
     LOG_DEBUG("cleanupMeshDB purged %d entries\n", removed);
+    rebuildSpatialIndex();
+    rebuildSlotIndexes();
+    invalidateOnlineCount();
+}
+
+void NodeDB::rebuildSlotIndexes()
+{
+    lastHeard.rebuild(*meshNodes, numMeshNodes);
+#if NODEDB_NUM_INDEX
+    slotIndex.clear();
+    for (int i = 0; i < numMeshNodes; i++)
+        slotIndex[meshNodes->at(i).num] = i;
+#endif
+}
+
+void NodeDB::rebuildSpatialIndex()
+{
+    spatialIndex.clear();
+    for (int i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &n = meshNodes->at(i);
+        if (n.num != getNodeNum() && hasValidPosition(&n))
+            spatialIndex.update(n.num, n.position.latitude_i, n.position.longitude_i);
+    }
 }
 
 void NodeDB::installDefaultDeviceState()
@@ -500,6 +534,9 @@ void NodeDB::installDefaultDeviceState()
 
     numMeshNodes = 0;
     meshNodes = &devicestate.node_db_lite;
+    spatialIndex.clear();
+    rebuildSlotIndexes();
+    invalidateOnlineCount();
 
     // init our devicestate with valid flags so protobuf writing/reading will work
     devicestate.has_my_node = true;
@@ -549,6 +586,9 @@ static const char *prefFileName = "/prefs/db.proto";
 static const char *configFileName = "/prefs/config.proto";
 static const char *moduleConfigFileName = "/prefs/module.proto";
 static const char *channelFileName = "/prefs/channels.proto";
+#ifdef ARCH_PORTDUINO
+static const char *nodeStoreFileName = "/prefs/nodes.dat";
+#endif
 static const char *oemConfigFile = "/oem/oem.proto";
 
 /** Load a protobuf from a file, return LoadFileResult */
@@ -591,7 +631,7 @@ LoadFileResult NodeDB::loadProto(const char *filename, size_t protoSize, size_t
 void NodeDB::loadFromDisk()
 {
     // static DeviceState scratch; We no longer read into a tempbuf because this structure is 15KB of valuable RAM
-    auto state = loadProto(prefFileName, sizeof(meshtastic_DeviceState) + MAX_NUM_NODES * sizeof(meshtastic_NodeInfo),
+    auto state = loadProto(prefFileName, sizeof(meshtastic_DeviceState) + maxNumNodes * sizeof(meshtastic_NodeInfo),
                            sizeof(meshtastic_DeviceState), &meshtastic_DeviceState_msg, &devicestate);
 
     if (state != LoadFileResult::SUCCESS) {
@@ -605,9 +645,18 @@ void NodeDB::loadFromDisk()
                      devicestate.node_db_lite.size());
             meshNodes = &devicestate.node_db_lite;
             numMeshNodes = devicestate.node_db_lite.size();
+            if (numMeshNodes > maxNumNodes) {
+                LOG_WARN("Only keeping %u of %u saved nodes\n", (unsigned)maxNumNodes, (unsigned)numMeshNodes);
+                numMeshNodes = maxNumNodes;
+            }
         }
     }
-    meshNodes->resize(MAX_NUM_NODES);
+    meshNodes->resize(maxNumNodes); // Drops the nodes past maxNumNodes, if there were more
+#ifdef ARCH_PORTDUINO
+    loadNodeStore();
+#endif
+    rebuildSlotIndexes();
+    invalidateOnlineCount();
 
     state = loadProto(configFileName, meshtastic_LocalConfig_size, sizeof(meshtastic_LocalConfig), &meshtastic_LocalConfig_msg,
                       &config);
@@ -655,6 +704,22 @@ void NodeDB::loadFromDisk()
 }
 
 /** Save a protobuf from a file, return true for success */
+#ifdef ARCH_PORTDUINO
+void NodeDB::loadNodeStore()
+{
+    FSCom.mkdir("/prefs");
+    std::string path = std::string(portduinoVFS->mountpoint()) + nodeStoreFileName;
+    if (!nodeStore.open(path, maxNumNodes))
+        return; // Keep using the protobuf
+
+    // Nodes from an older protobuf only DB stay as loaded, they will be moved to the store on our next save
+    if (nodeStore.size()) {
+        numMeshNodes = nodeStore.load(*meshNodes, maxNumNodes);
+        LOG_INFO("Loaded %d nodes from the node store\n", numMeshNodes);
+    }
+}
+#endif
+
 bool NodeDB::saveProto(const char *filename, size_t protoSize, const pb_msgdesc_t *fields, const void *dest_struct)
 {
     bool okay = false;
@@ -716,6 +781,18 @@ void NodeDB::saveDeviceStateToDisk()
 {
 #ifdef FSCom
     FSCom.mkdir("/prefs");
+#endif
+#ifdef ARCH_PORTDUINO
+    if (nodeStore.isOpen()) {
+        nodeStore.save(*meshNodes, numMeshNodes);
+
+        // Keep the nodes out of the protobuf. Swapping leaves them where they are, so pointers to them stay valid
+        std::vector<meshtastic_NodeInfoLite> nodes;
+        nodes.swap(devicestate.node_db_lite);
+        saveProto(prefFileName, sizeof(devicestate), &meshtastic_DeviceState_msg, &devicestate);
+        nodes.swap(devicestate.node_db_lite);
+        return;
+    }
 #endif
     saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size, &meshtastic_DeviceState_msg,
               &devicestate);
@@ -797,21 +874,73 @@ uint32_t sinceReceived(const meshtastic_MeshPacket *p)
 
 #define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
 
-size_t NodeDB::getNumOnlineMeshNodes(bool localOnly)
+// Recount the online nodes at least this often, in case a last_heard was changed behind our back
+#ifndef ONLINE_RECOUNT_SECS
+#define ONLINE_RECOUNT_SECS 60
+#endif
+
+/// Same as sinceLastSeen(n) < NUM_ONLINE_SECS, but without asking for the time again
+static bool isOnlineAt(const meshtastic_NodeInfoLite &n, uint32_t now)
+{
+    int delta = (int)(now - n.last_heard);
+    return delta < NUM_ONLINE_SECS; // a negative delta is a clock not set yet, which counts as just heard
+}
+
+size_t NodeDB::countOnlineMeshNodes(bool localOnly, uint32_t now, uint32_t *firstExpiry)
 {
     size_t numseen = 0;
 
-    // FIXME this implementation is kinda expensive
     for (int i = 0; i < numMeshNodes; i++) {
-        if (localOnly && meshNodes->at(i).via_mqtt)
+        const meshtastic_NodeInfoLite &n = meshNodes->at(i);
+        if (localOnly && n.via_mqtt)
             continue;
-        if (sinceLastSeen(&meshNodes->at(i)) < NUM_ONLINE_SECS)
+        if (isOnlineAt(n, now)) {
             numseen++;
+            if (firstExpiry && n.last_heard + NUM_ONLINE_SECS < *firstExpiry)
+                *firstExpiry = n.last_heard + NUM_ONLINE_SECS;
+        }
     }
 
     return numseen;
 }
 
+size_t NodeDB::getNumOnlineMeshNodes(bool localOnly)
+{
+    uint32_t now = getTime();
+    if (localOnly)
+        return countOnlineMeshNodes(true, now); // Only MQTT needs this, and not often
+
+    // Our cached count stays right until the first counted node goes offline, or our clock is changed
+    if (onlineCountExpires == 0 || now >= onlineCountExpires || now < onlineCountedAt) {
+        onlineCountExpires = now + ONLINE_RECOUNT_SECS;
+        onlineCountedAt = now;
+        numOnlineNodes = countOnlineMeshNodes(false, now, &onlineCountExpires);
+    }
+    return numOnlineNodes;
+}
+
+void NodeDB::notifyObservers(bool forceUpdate)
+{
+    statusForced |= forceUpdate;
+    if (!statusPending) {
+        statusPending = true;
+        enabled = true;
+        setIntervalFromNow(0);
+        runASAP = true;
+    }
+}
+
+int32_t NodeDB::runOnce()
+{
+    if (statusPending) {
+        // Notify observers of the current node state
+        const meshtastic::NodeStatus status = meshtastic::NodeStatus(getNumOnlineMeshNodes(), getNumMeshNodes(), statusForced);
+        statusPending = statusForced = false;
+        newStatus.notifyObservers(&status);
+    }
+    return disable(); // Until the next change
+}
+
 #include "MeshModule.h"
 #include "Throttle.h"
 
@@ -855,6 +984,15 @@ void NodeDB::updatePosition(uint32_t nodeId, const meshtastic_Position &p, RxSou
             info->position.time = tmp_time;
     }
     info->has_position = true;
+
+    // Keep the spatial index current (our own node isn't indexed, queries are for other nodes)
+    if (nodeId != getNodeNum()) {
+        if (hasValidPosition(info))
+            spatialIndex.update(nodeId, info->position.latitude_i, info->position.longitude_i);
+        else
+            spatialIndex.remove(nodeId);
+    }
+
     updateGUIforNode = info;
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
@@ -929,8 +1067,22 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             return;
         }
 
-        if (mp.rx_time) // if the packet has a valid timestamp use it to update our last_heard
+        if (mp.rx_time) { // if the packet has a valid timestamp use it to update our last_heard
+            uint32_t now = getTime();
+            bool wasOnline = isOnlineAt(*info, now);
             info->last_heard = mp.rx_time;
+            // Keep our cached online count current, rather than walking the whole DB again
+            if (onlineCountExpires) {
+                bool isOnline = isOnlineAt(*info, now);
+                if (isOnline && !wasOnline)
+                    numOnlineNodes++;
+                else if (!isOnline && wasOnline && numOnlineNodes)
+                    numOnlineNodes--;
+                if (isOnline)
+                    onlineCountExpires = min(onlineCountExpires, info->last_heard + NUM_ONLINE_SECS);
+            }
+            lastHeard.touch(*meshNodes, slotOf(info));
+        }
 
         if (mp.rx_snr)
             info->snr = mp.rx_snr; // keep the most recent SNR we received for this node.
@@ -956,11 +1108,16 @@ uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
 /// NOTE: This function might be called from an ISR
 meshtastic_NodeInfoLite *NodeDB::getMeshNode(NodeNum n)
 {
+#if NODEDB_NUM_INDEX
+    auto found = slotIndex.find(n);
+    return (found != slotIndex.end()) ? &meshNodes->at(found->second) : NULL;
+#else
     for (int i = 0; i < numMeshNodes; i++)
         if (meshNodes->at(i).num == n)
             return &meshNodes->at(i);
 
     return NULL;
+#endif
 }
 
 /// Find a node in our DB, create an empty NodeInfo if missing
@@ -969,36 +1126,50 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
     meshtastic_NodeInfoLite *lite = getMeshNode(n);
 
     if (!lite) {
-        if ((numMeshNodes >= MAX_NUM_NODES) || (memGet.getFreeHeap() < meshtastic_NodeInfoLite_size * 3)) {
+        if ((numMeshNodes >= maxNumNodes) || (memGet.getFreeHeap() < meshtastic_NodeInfoLite_size * 3)) {
             if (screen)
                 screen->print("Warn: node database full!\nErasing oldest entry\n");
             LOG_WARN("Node database full! Erasing oldest entry\n");
-            // look for oldest node and erase it
-            uint32_t oldest = UINT32_MAX;
-            int oldestIndex = -1;
-            for (int i = 1; i < numMeshNodes; i++) {
-                if (!meshNodes->at(i).is_favorite && meshNodes->at(i).last_heard < oldest) {
-                    oldest = meshNodes->at(i).last_heard;
-                    oldestIndex = i;
-                }
+            // Reuse the slot of the oldest node, so no other node moves
+            uint16_t slot = findEvictableSlot();
+            if (slot == NodeLastHeardList::NONE) {
+                LOG_WARN("No node we can erase, not adding 0x%x\n", n);
+                return NULL;
             }
-            // Shove the remaining nodes down the chain
-            for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
-                meshNodes->at(i) = meshNodes->at(i + 1);
-            }
-            (numMeshNodes)--;
+            lite = &meshNodes->at(slot);
+            spatialIndex.remove(lite->num);
+#if NODEDB_NUM_INDEX
+            slotIndex.erase(lite->num);
+#endif
+        } else {
+            // add the node at the end
+            lite = &meshNodes->at((numMeshNodes)++);
         }
-        // add the node at the end
-        lite = &meshNodes->at((numMeshNodes)++);
+        invalidateOnlineCount(); // Before our clock is set, a node never heard from counts as online
 
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        lastHeard.addOldest(slotOf(lite));
+#if NODEDB_NUM_INDEX
+        slotIndex[n] = slotOf(lite);
+#endif
     }
 
     return lite;
 }
 
+uint16_t NodeDB::findEvictableSlot() const
+{
+    // Favorites are never evicted, so skip past them from the oldest end
+    for (uint16_t slot = lastHeard.oldest(); slot != NodeLastHeardList::NONE; slot = lastHeard.newer(slot)) {
+        const meshtastic_NodeInfoLite &node = meshNodes->at(slot);
+        if (!node.is_favorite && node.num != myNodeInfo.my_node_num)
+            return slot;
+    }
+    return NodeLastHeardList::NONE;
+}
+
 /// Record an error that should be reported via analytics
 void recordCriticalError(meshtastic_CriticalErrorCode code, uint32_t address, const char *filename)
 {
@@ -3,13 +3,30 @@
 #include "Observer.h"
 #include <Arduino.h>
 #include <assert.h>
+#include <unordered_map>
 #include <vector>
 
 #include "MeshTypes.h"
+#include "NodeLastHeardList.h"
+#include "NodeSpatialIndex.h"
+#include "concurrency/OSThread.h"
 #include "NodeStatus.h"
 #include "mesh-pb-constants.h"
 #include "mesh/generated/meshtastic/mesh.pb.h" // For CriticalErrorCode
 
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/NodeStore.h"
+#endif
+
+/// Look nodes up by number through a hash index, rather than by scanning the DB. Worth it for large DBs
+#ifndef NODEDB_NUM_INDEX
+#ifdef ARCH_PORTDUINO
+#define NODEDB_NUM_INDEX 1
+#else
+#define NODEDB_NUM_INDEX 0
+#endif
+#endif
+
 /*
 DeviceState versions used to be defined in the .proto file but really only this function cares.  So changed to a
 #define here.
@@ -51,7 +68,13 @@ enum LoadFileResult {
     OTHER_FAILURE = 5
 };
 
-class NodeDB
+/**
+ * Our DB of every node we have heard from.
+ *
+ * It is also a thread, only so that the status updates of every change made during one scheduler tick can be sent to our
+ * observers as a single NodeStatus.
+ */
+class NodeDB : private concurrency::OSThread
 {
     // NodeNum provisionalNodeNum; // if we are trying to find a node num this is our current attempt
 
@@ -145,6 +168,21 @@ class NodeDB
     meshtastic_NodeInfoLite *getMeshNode(NodeNum n);
     size_t getNumMeshNodes() { return numMeshNodes; }
 
+    /// How many nodes we keep before evicting the oldest. MAX_NUM_NODES, or General.MaxNodes on Portduino
+    size_t getMaxNumNodes() const { return maxNumNodes; }
+
+    /// Other nodes with a known position within radiusMeters of a point, nearest first. Coordinates in 1e-7 degrees
+    size_t getNodesWithin(int32_t latitude, int32_t longitude, float radiusMeters, std::vector<NodeDistance> &results) const
+    {
+        return spatialIndex.findWithin(latitude, longitude, radiusMeters, results);
+    }
+
+    /// The (up to) count other nodes with a known position nearest to a point, nearest first. Coordinates in 1e-7 degrees
+    size_t getNearestNodes(int32_t latitude, int32_t longitude, size_t count, std::vector<NodeDistance> &results) const
+    {
+        return spatialIndex.findNearest(latitude, longitude, count, results);
+    }
+
     void clearLocalPosition();
 
     void setLocalPosition(meshtastic_Position position, bool timeOnly = false)
@@ -162,25 +200,61 @@ class NodeDB
 
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+    NodeSpatialIndex spatialIndex; // positions of every other node, for range queries
+    NodeLastHeardList lastHeard;   // our slots by last_heard, to find the node to evict when full
+    size_t maxNumNodes = MAX_NUM_NODES;
+#if NODEDB_NUM_INDEX
+    std::unordered_map<NodeNum, uint16_t> slotIndex; // which slot each node is in
+#endif
+#ifdef ARCH_PORTDUINO
+    NodeStore nodeStore; // our nodes, when they're kept outside the DeviceState protobuf
+#endif
+
+    /// Re-index the positions of every node in the DB
+    void rebuildSpatialIndex();
+    /// Rebuild the indexes of our slots (lastHeard and slotIndex), after nodes moved between slots
+    void rebuildSlotIndexes();
+    /// Slot of a node within meshNodes
+    uint16_t slotOf(const meshtastic_NodeInfoLite *n) const { return n - meshNodes->data(); }
+    /// The slot of the least recently heard node we may evict (not us or a favorite), NONE if there is none
+    uint16_t findEvictableSlot() const;
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
-    /// Notify observers of changes to the DB
-    void notifyObservers(bool forceUpdate = false)
-    {
-        // Notify observers of the current node state
-        const meshtastic::NodeStatus status = meshtastic::NodeStatus(getNumOnlineMeshNodes(), getNumMeshNodes(), forceUpdate);
-        newStatus.notifyObservers(&status);
-    }
+    bool statusPending = false; // a NodeStatus will be sent on our next run
+    bool statusForced = false;  // and it should be sent even if the node counts haven't changed
+
+    // getNumOnlineMeshNodes() is cached, it is only recounted once a counted node might have gone offline
+    size_t numOnlineNodes = 0;
+    uint32_t onlineCountedAt = 0;    // getTime() of the last recount
+    uint32_t onlineCountExpires = 0; // getTime() at which we must recount, 0 if numOnlineNodes is stale
+
+    /// Notify observers of changes to the DB. Coalesced, so a burst of updates sends one NodeStatus
+    void notifyObservers(bool forceUpdate = false);
+
+    /// Count the nodes heard within NUM_ONLINE_SECS of now, and when the first of them will go offline
+    size_t countOnlineMeshNodes(bool localOnly, uint32_t now, uint32_t *firstExpiry = NULL);
+
+    /// Force a recount of the online nodes, after nodes were added to or removed from the DB
+    void invalidateOnlineCount() { onlineCountExpires = 0; }
 
     /// read our db from flash
     void loadFromDisk();
 
+#ifdef ARCH_PORTDUINO
+    /// Open our NodeStore, taking the nodes from it if it has any
+    void loadNodeStore();
+#endif
+
     /// purge db entries without user info
     void cleanupMeshDB();
 
     /// Reinit device state from scratch (not loading from disk)
     void installDefaultDeviceState(), installDefaultChannels(), installDefaultConfig(), installDefaultModuleConfig();
+
+  protected:
+    /// Send our pending NodeStatus, if any
+    virtual int32_t runOnce() override;
 };
 
 extern NodeDB *nodeDB;
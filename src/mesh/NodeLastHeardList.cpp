@@ -0,0 +1,76 @@
+#include "NodeLastHeardList.h"
+#include <algorithm>
+
+void NodeLastHeardList::rebuild(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count)
+{
+    clear();
+
+    std::vector<uint16_t> slots(count);
+    for (size_t i = 0; i < count; i++)
+        slots[i] = i;
+    std::stable_sort(slots.begin(), slots.end(),
+                     [&nodes](uint16_t a, uint16_t b) { return nodes[a].last_heard > nodes[b].last_heard; });
+
+    for (uint16_t slot : slots)
+        insertBefore(slot, NONE);
+}
+
+void NodeLastHeardList::clear()
+{
+    links.clear();
+    head = tail = NONE;
+}
+
+void NodeLastHeardList::touch(const std::vector<meshtastic_NodeInfoLite> &nodes, uint16_t slot)
+{
+    remove(slot);
+
+    // Usually we just heard from it, so this stops at the head
+    uint32_t lastHeard = nodes[slot].last_heard;
+    uint16_t before = head;
+    while (before != NONE && nodes[before].last_heard > lastHeard)
+        before = links[before].next;
+    insertBefore(slot, before);
+}
+
+void NodeLastHeardList::addOldest(uint16_t slot)
+{
+    remove(slot);
+    insertBefore(slot, NONE);
+}
+
+void NodeLastHeardList::remove(uint16_t slot)
+{
+    if (slot >= links.size() || !links[slot].linked)
+        return;
+
+    Link &l = links[slot];
+    if (l.prev != NONE)
+        links[l.prev].next = l.next;
+    else
+        head = l.next;
+    if (l.next != NONE)
+        links[l.next].prev = l.prev;
+    else
+        tail = l.prev;
+    l = Link();
+}
+
+void NodeLastHeardList::insertBefore(uint16_t slot, uint16_t before)
+{
+    if (slot >= links.size())
+        links.resize(slot + 1);
+
+    Link &l = links[slot];
+    l.linked = true;
+    l.next = before;
+    l.prev = (before != NONE) ? links[before].prev : tail;
+    if (l.prev != NONE)
+        links[l.prev].next = slot;
+    else
+        head = slot;
+    if (before != NONE)
+        links[before].prev = slot;
+    else
+        tail = slot;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "mesh/generated/meshtastic/deviceonly.pb.h"
+#include <vector>
+
+/**
+ * The slots of NodeDB::meshNodes threaded into a doubly linked list ordered by last_heard, newest first.
+ *
+ * When the DB is full this gives the node to evict without scanning every slot, and as the evicted slot is reused in
+ * place none of the other nodes move. Maintained by NodeDB whenever a last_heard changes or slots are added or removed.
+ */
+class NodeLastHeardList
+{
+  public:
+    static const uint16_t NONE = UINT16_MAX;
+
+    /// Relink the first count slots of nodes, sorted by last_heard
+    void rebuild(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count);
+
+    void clear();
+
+    /// Move a slot to its place for its (new) last_heard, adding it if it isn't linked yet
+    void touch(const std::vector<meshtastic_NodeInfoLite> &nodes, uint16_t slot);
+
+    /// Add a slot whose last_heard is no newer than any linked slot, e.g. a node we haven't heard from yet
+    void addOldest(uint16_t slot);
+
+    /// Unlink a slot, if linked
+    void remove(uint16_t slot);
+
+    /// The slot least recently heard from, NONE if the list is empty
+    uint16_t oldest() const { return tail; }
+
+    /// The next slot towards the newest, NONE at the head
+    uint16_t newer(uint16_t slot) const { return links[slot].prev; }
+
+  private:
+    struct Link {
+        uint16_t prev = NONE; // Heard more recently
+        uint16_t next = NONE; // Heard less recently
+        bool linked = false;
+    };
+
+    std::vector<Link> links; // Indexed by slot
+    uint16_t head = NONE, tail = NONE;
+
+    /// Link slot in front of before (at the tail if before is NONE)
+    void insertBefore(uint16_t slot, uint16_t before);
+};
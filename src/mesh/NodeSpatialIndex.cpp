@@ -0,0 +1,150 @@
+#include "NodeSpatialIndex.h"
+#include "gps/GeoCoord.h"
+#include <algorithm>
+
+// Grid dimensions
+static const int32_t NUM_ROWS = (1800000000LL / NODE_INDEX_CELL_E7) + 1;
+static const int32_t NUM_COLUMNS = (3600000000LL / NODE_INDEX_CELL_E7) + 1;
+
+// Size of one cell north-south, matching the earth radius used by GeoCoord
+static const float CELL_HEIGHT_METERS = 6366000 * (float)(PI / 180) * (NODE_INDEX_CELL_E7 * 1e-7f);
+
+static int32_t rowOf(int32_t latitude)
+{
+    return (int32_t)(((int64_t)latitude + 900000000LL) / NODE_INDEX_CELL_E7);
+}
+
+static int32_t columnOf(int32_t longitude)
+{
+    return (int32_t)(((int64_t)longitude + 1800000000LL) / NODE_INDEX_CELL_E7);
+}
+
+uint32_t NodeSpatialIndex::cellKey(int32_t latitude, int32_t longitude)
+{
+    return makeKey(rowOf(latitude), columnOf(longitude));
+}
+
+void NodeSpatialIndex::update(NodeNum num, int32_t latitude, int32_t longitude)
+{
+    uint32_t key = cellKey(latitude, longitude);
+
+    auto found = nodes.find(num);
+    if (found != nodes.end()) {
+        std::vector<Entry> &cell = cells[found->second];
+        auto e = std::find_if(cell.begin(), cell.end(), [num](const Entry &e) { return e.num == num; });
+
+        // Still in the same cell, just update the coordinates
+        if (found->second == key && e != cell.end()) {
+            e->latitude = latitude;
+            e->longitude = longitude;
+            return;
+        }
+        remove(num);
+    }
+
+    cells[key].push_back(Entry{num, latitude, longitude});
+    nodes[num] = key;
+}
+
+void NodeSpatialIndex::remove(NodeNum num)
+{
+    auto found = nodes.find(num);
+    if (found == nodes.end())
+        return;
+
+    auto cell = cells.find(found->second);
+    if (cell != cells.end()) {
+        std::vector<Entry> &entries = cell->second;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].num == num) {
+                entries[i] = entries.back(); // Order within a cell doesn't matter
+                entries.pop_back();
+                break;
+            }
+        }
+        if (entries.empty())
+            cells.erase(cell);
+    }
+    nodes.erase(found);
+}
+
+void NodeSpatialIndex::clear()
+{
+    cells.clear();
+    nodes.clear();
+}
+
+void NodeSpatialIndex::consider(const Entry &e, int32_t latitude, int32_t longitude, float radiusMeters,
+                                std::vector<NodeDistance> &results)
+{
+    float distance = GeoCoord::latLongToMeterFast(latitude, longitude, e.latitude, e.longitude);
+    if (distance <= radiusMeters)
+        results.push_back(NodeDistance{e.num, distance});
+}
+
+size_t NodeSpatialIndex::findWithin(int32_t latitude, int32_t longitude, float radiusMeters,
+                                    std::vector<NodeDistance> &results) const
+{
+    results.clear();
+
+    // How many cells the radius spans north-south
+    const int32_t rowSpan = (int32_t)ceilf(radiusMeters / CELL_HEIGHT_METERS);
+    const int32_t centerRow = rowOf(latitude);
+    const int32_t firstRow = std::max(centerRow - rowSpan, 0);
+    const int32_t lastRow = std::min(centerRow + rowSpan, NUM_ROWS - 1);
+
+    // Cells get narrower away from the equator: use the width at whichever edge of the search area is nearer a pole
+    const float edgeLatitude = std::max(fabsf((firstRow * (float)NODE_INDEX_CELL_E7 - 900000000.0f) * 1e-7f),
+                                        fabsf(((lastRow + 1) * (float)NODE_INDEX_CELL_E7 - 900000000.0f) * 1e-7f));
+    const float cellWidthMeters = CELL_HEIGHT_METERS * cosf(std::min(edgeLatitude, 90.0f) * (float)(PI / 180));
+    int32_t columnSpan = NUM_COLUMNS;
+    if (cellWidthMeters > 1)
+        columnSpan = std::min((int32_t)ceilf(radiusMeters / cellWidthMeters), NUM_COLUMNS);
+
+    const uint64_t cellsToVisit = (uint64_t)(lastRow - firstRow + 1) * (2 * columnSpan + 1);
+
+    if (cellsToVisit >= cells.size() || 2 * columnSpan + 1 >= NUM_COLUMNS) {
+        // Search area covers more cells than are occupied: cheaper to just look at them all
+        for (auto &cell : cells)
+            for (auto &e : cell.second)
+                consider(e, latitude, longitude, radiusMeters, results);
+    } else {
+        const int32_t centerColumn = columnOf(longitude);
+        for (int32_t row = firstRow; row <= lastRow; row++) {
+            for (int32_t c = centerColumn - columnSpan; c <= centerColumn + columnSpan; c++) {
+                const int32_t column = (c + NUM_COLUMNS) % NUM_COLUMNS; // Wrap around the antimeridian
+                auto cell = cells.find(makeKey(row, column));
+                if (cell == cells.end())
+                    continue;
+                for (auto &e : cell->second)
+                    consider(e, latitude, longitude, radiusMeters, results);
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end(),
+              [](const NodeDistance &a, const NodeDistance &b) { return a.distance < b.distance; });
+    return results.size();
+}
+
+size_t NodeSpatialIndex::findNearest(int32_t latitude, int32_t longitude, size_t count, std::vector<NodeDistance> &results) const
+{
+    results.clear();
+    if (count == 0 || nodes.empty())
+        return 0;
+
+    // Widen the search until it finds enough nodes. Every node inside the radius is found,
+    // so once there are at least count of them, the nearest count are the nearest overall
+    const float halfEarthMeters = 6366000 * (float)PI;
+    float radius = CELL_HEIGHT_METERS;
+    while (true) {
+        findWithin(latitude, longitude, radius, results);
+        if (results.size() >= count || radius >= halfEarthMeters)
+            break;
+        radius *= 4;
+    }
+
+    if (results.size() > count)
+        results.resize(count);
+    return results.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <unordered_map>
+#include <vector>
+
+/// Grid cell size, in 1e-7 degrees. The default of 0.1 degree is roughly 11 km north-south
+#ifndef NODE_INDEX_CELL_E7
+#define NODE_INDEX_CELL_E7 1000000
+#endif
+
+/// A node returned by a spatial query
+struct NodeDistance {
+    NodeNum num;
+    float distance; // meters
+};
+
+/**
+ * A grid index over node positions, so that "which nodes are within X km" and "nearest N nodes" only look at the
+ * surrounding cells instead of measuring the distance to every node in the DB.
+ *
+ * Maintained by NodeDB whenever a node's position changes, or a node is removed.
+ */
+class NodeSpatialIndex
+{
+  public:
+    /// Add a node, or move it if already indexed. Coordinates in 1e-7 degrees
+    void update(NodeNum num, int32_t latitude, int32_t longitude);
+
+    /// Remove a node, if indexed
+    void remove(NodeNum num);
+
+    void clear();
+
+    size_t size() const { return nodes.size(); }
+
+    /**
+     * Find every node within radiusMeters of a point, nearest first
+     * @return number of nodes found
+     */
+    size_t findWithin(int32_t latitude, int32_t longitude, float radiusMeters, std::vector<NodeDistance> &results) const;
+
+    /**
+     * Find the (up to) count nodes nearest to a point, nearest first
+     * @return number of nodes found
+     */
+    size_t findNearest(int32_t latitude, int32_t longitude, size_t count, std::vector<NodeDistance> &results) const;
+
+  private:
+    struct Entry {
+        NodeNum num;
+        int32_t latitude;
+        int32_t longitude;
+    };
+
+    /// Which cell contains this point
+    static uint32_t cellKey(int32_t latitude, int32_t longitude);
+    static uint32_t makeKey(int32_t row, int32_t column) { return ((uint32_t)row << 16) | (uint32_t)column; }
+
+    /// Measure an entry, adding it to the results if within range
+    static void consider(const Entry &e, int32_t latitude, int32_t longitude, float radiusMeters,
+                         std::vector<NodeDistance> &results);
+
+    std::unordered_map<uint32_t, std::vector<Entry>> cells; // Nodes in each occupied grid cell
+    std::unordered_map<NodeNum, uint32_t> nodes;            // Which cell each node is in
+};
@@ -161,10 +161,10 @@ bool RF95Interface::reconfigure()
 /**
  * Add SNR data to received messages
  */
-void RF95Interface::addReceiveMetadata(meshtastic_MeshPacket *mp)
+void RF95Interface::addReceiveMetadata(RadioFrame *frame)
 {
-    mp->rx_snr = lora->getSNR();
-    mp->rx_rssi = lround(lora->getRSSI());
+    frame->snr = lora->getSNR();
+    frame->rssi = lround(lora->getRSSI());
 }
 
 void RF95Interface::setStandby()
@@ -56,7 +56,7 @@ class RF95Interface : public RadioLibInterface
     /**
      * Add SNR data to received messages
      */
-    virtual void addReceiveMetadata(meshtastic_MeshPacket *mp) override;
+    virtual void addReceiveMetadata(RadioFrame *frame) override;
 
     virtual void setStandby() override;
 
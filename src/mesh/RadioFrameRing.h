@@ -0,0 +1,59 @@
+#pragma once
+
+#include "RadioInterface.h"
+#include <atomic>
+
+/// How many received frames can wait for the router. Must be a power of two
+#ifndef RX_FRAME_RING_SIZE
+#define RX_FRAME_RING_SIZE 8
+#endif
+
+static_assert((RX_FRAME_RING_SIZE & (RX_FRAME_RING_SIZE - 1)) == 0, "RX_FRAME_RING_SIZE must be a power of two");
+
+/// A frame as read from the radio (PacketHeader and encrypted payload), with what the radio measured receiving it
+struct RadioFrame {
+    uint8_t bytes[MAX_RHPACKETLEN];
+    uint16_t length;
+    float snr;
+    int32_t rssi;
+    uint32_t rxMsec;
+};
+
+/**
+ * A preallocated single producer (the radio) / single consumer (the router) ring of received frames.
+ *
+ * The radio reads each frame straight into a slot, and the router parses it in place when it drains the ring. So nothing
+ * is taken from the packet pool, and no header is parsed, until the router gets to the frame.
+ */
+class RadioFrameRing
+{
+  public:
+    /// The slot to read the next frame into, NULL if the ring is full. Producer only
+    RadioFrame *beginWrite()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= RX_FRAME_RING_SIZE)
+            return NULL;
+        return &frames[h & (RX_FRAME_RING_SIZE - 1)];
+    }
+
+    /// Hand the slot from beginWrite() to the consumer
+    void commitWrite() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /// The oldest frame, NULL if the ring is empty. Consumer only
+    const RadioFrame *peek() const
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return NULL;
+        return &frames[t & (RX_FRAME_RING_SIZE - 1)];
+    }
+
+    /// Give the slot from peek() back to the producer
+    void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  private:
+    RadioFrame frames[RX_FRAME_RING_SIZE];
+    std::atomic<uint32_t> head{0}; // Frames written, only changed by the producer
+    std::atomic<uint32_t> tail{0}; // Frames consumed, only changed by the consumer
+};
@@ -227,7 +227,7 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
     uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d\n", packetAirtime, slotTimeMsec);
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = airTime->congestionPercent();
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
     return 2 * packetAirtime + (pow(2, CWsize) + 2 * CWmax + pow(2, int((CWmax + CWmin) / 2))) * slotTimeMsec +
@@ -235,13 +235,18 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
 }
 
 /** The delay to use when we want to send something */
+uint8_t RadioInterface::getCWsize(float channelUtil, const TxBackoff &b) const
+{
+    return b.apply(map(channelUtil, 0, 100, CWmin, CWmax), CWmax);
+}
+
 uint32_t RadioInterface::getTxDelayMsec()
 {
     /** We wait a random multiple of 'slotTimes' (see definition in header file) in order to avoid collisions.
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
-    float channelUtil = airTime->channelUtilizationPercent();
-    uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
+    float channelUtil = airTime->congestionPercent();
+    uint8_t CWsize = getCWsize(channelUtil, backoff);
     // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d\n", channelUtil, CWsize);
     return random(0, pow(2, CWsize)) * slotTimeMsec;
 }
@@ -258,7 +263,7 @@ uint32_t RadioInterface::getTxDelayMsecWeighted(float snr)
     //  high SNR = large CW size (Long Delay)
     //  low SNR = small CW size (Short Delay)
     uint32_t delay = 0;
-    uint8_t CWsize = map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax);
+    uint8_t CWsize = backoff.apply(map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax), CWmax);
     // LOG_DEBUG("rx_snr of %f so setting CWsize to:%d\n", snr, CWsize);
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ||
         config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER_CLIENT ||
@@ -567,14 +572,22 @@ size_t RadioInterface::beginSending(meshtastic_MeshPacket *p)
 
     lastTxStart = millis();
 
-    PacketHeader *h = (PacketHeader *)radiobuf;
+    size_t len = encodeFrame(p, radiobuf);
+
+    sendingPacket = p;
+    return len;
+}
+
+size_t RadioInterface::encodeFrame(meshtastic_MeshPacket *p, uint8_t *buf)
+{
+    PacketHeader *h = (PacketHeader *)buf;
 
     h->from = p->from;
     h->to = p->to;
     h->id = p->id;
     h->channel = p->channel;
-    h->next_hop = 0;   // *** For future use ***
-    h->relay_node = 0; // *** For future use ***
+    h->next_hop = router ? router->getNextHop(p) : NO_NEXT_HOP;
+    h->relay_node = (uint8_t)nodeDB->getNodeNum();
     if (p->hop_limit > HOP_MAX) {
         LOG_WARN("hop limit %d is too high, setting to %d\n", p->hop_limit, HOP_RELIABLE);
         p->hop_limit = HOP_RELIABLE;
@@ -585,8 +598,6 @@ size_t RadioInterface::beginSending(meshtastic_MeshPacket *p)
     // if the sender nodenum is zero, that means uninitialized
     assert(h->from);
 
-    memcpy(radiobuf + sizeof(PacketHeader), p->encrypted.bytes, p->encrypted.size);
-
-    sendingPacket = p;
+    memcpy(buf + sizeof(PacketHeader), p->encrypted.bytes, p->encrypted.size);
     return p->encrypted.size + sizeof(PacketHeader);
 }
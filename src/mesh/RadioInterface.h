@@ -4,6 +4,7 @@
 #include "MeshTypes.h"
 #include "Observer.h"
 #include "PointerQueue.h"
+#include "TxBackoff.h"
 #include "airtime.h"
 
 #define MAX_TX_QUEUE 16 // max number of packets which can be waiting for transmission
@@ -16,6 +17,9 @@
 #define PACKET_FLAGS_HOP_START_MASK 0xE0
 #define PACKET_FLAGS_HOP_START_SHIFT 5
 
+/// The next_hop / relay_node value for none, as sent by older firmware
+#define NO_NEXT_HOP 0
+
 /**
  * This structure has to exactly match the wire layout when sent over the radio link.  Used to keep compatibility
  * with the old radiohead implementation.
@@ -35,10 +39,10 @@ typedef struct {
     /** The channel hash - used as a hint for the decoder to limit which channels we consider */
     uint8_t channel;
 
-    // ***For future use*** Last byte of the NodeNum of the next-hop for this packet
+    // Last byte of the NodeNum of the next-hop for this packet, NO_NEXT_HOP to flood it
     uint8_t next_hop;
 
-    // ***For future use*** Last byte of the NodeNum of the node that will relay/relayed this packet
+    // Last byte of the NodeNum of the node that will relay/relayed this packet
     uint8_t relay_node;
 } PacketHeader;
 
@@ -80,6 +84,9 @@ class RadioInterface
     const uint8_t CWmin = 2; // minimum CWsize
     const uint8_t CWmax = 8; // maximum CWsize
 
+    /// Widens the contention window while we see collisions and a busy channel
+    TxBackoff backoff;
+
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
 
@@ -158,6 +165,16 @@ class RadioInterface
     /** The delay to use when we want to flood a message. Use a weighted scale based on SNR */
     uint32_t getTxDelayMsecWeighted(float snr);
 
+    /** The contention window (as a power of two of slots) to use with this channel utilization, widened by back-off */
+    uint8_t getCWsize(float channelUtil, const TxBackoff &b) const;
+
+    uint32_t getSlotTimeMsec() const { return slotTimeMsec; }
+
+    /// One of our packets wasn't acknowledged, so its transmission most likely collided
+    void noteTxCollision() { backoff.noteCollision(); }
+
+    const TxBackoffStats &getBackoffStats() const { return backoff.getStats(); }
+
     /**
      * Calculate airtime per
      * https://www.rs-online.com/designspark/rel-assets/ds-assets/uploads/knowledge-items/application-notes-for-the-internet-of-things/LoRa%20Design%20Guide.pdf
@@ -198,6 +215,9 @@ class RadioInterface
      */
     size_t beginSending(meshtastic_MeshPacket *p);
 
+    /// Write the PacketHeader and encrypted payload of a packet to buf, returns the frame length
+    size_t encodeFrame(meshtastic_MeshPacket *p, uint8_t *buf);
+
     /**
      * Some regulatory regions limit xmit power.
      * This function should be called by subclasses after setting their desired power.  It might lower it
@@ -1,6 +1,7 @@
 #include "RadioLibInterface.h"
 #include "MeshTypes.h"
 #include "NodeDB.h"
+#include "Router.h"
 #include "SPILock.h"
 #include "configuration.h"
 #include "error.h"
@@ -80,12 +81,13 @@ bool RadioLibInterface::canSendImmediately()
     // We wait _if_ we are partially though receiving a packet (rather than just merely waiting for one).
     // To do otherwise would be doubly bad because not only would we drop the packet that was on the way in,
     // we almost certainly guarantee no one outside will like the packet we are sending.
-    bool busyTx = sendingPacket != NULL;
+    bool busyTx = sendingPacket != NULL || sendingHello;
     bool busyRx = isReceiving && isActivelyReceiving();
 
     if (busyTx || busyRx) {
         if (busyTx) {
             LOG_WARN("Can not send yet, busyTx\n");
+            stats.busyTxDeferrals++;
         }
         // If we've been trying to send the same packet more than one minute and we haven't gotten a
         // TX IRQ from the radio, the radio is probably broken.
@@ -97,6 +99,7 @@ bool RadioLibInterface::canSendImmediately()
         }
         if (busyRx) {
             LOG_WARN("Can not send yet, busyRx\n");
+            stats.busyRxDeferrals++;
         }
         return false;
     } else
@@ -138,13 +141,15 @@ ErrorCode RadioLibInterface::send(meshtastic_MeshPacket *p)
 #ifndef LORA_DISABLE_SENDING
     printPacket("enqueuing for send", p);
 
-    LOG_DEBUG("txGood=%d,rxGood=%d,rxBad=%d\n", txGood, rxGood, rxBad);
+    LOG_DEBUG("txGood=%d,rxGood=%d,rxBad=%d\n", stats.txGood, stats.rxGood,
+              stats.rxCrcErrors + stats.rxOtherErrors + stats.rxTooShort);
     ErrorCode res = txQueue.enqueue(p) ? ERRNO_OK : ERRNO_UNKNOWN;
 
     if (res != ERRNO_OK) { // we weren't able to queue it, so we must drop it to prevent leaks
         packetPool.release(p);
         return res;
     }
+    noteQueued(p);
 
     // set (random) transmit delay to let others reconfigure their radio,
     // to avoid collisions and implement timing-based flooding
@@ -182,14 +187,47 @@ bool RadioLibInterface::canSleep()
 bool RadioLibInterface::cancelSending(NodeNum from, PacketId id)
 {
     auto p = txQueue.remove(from, id);
-    if (p)
+    if (p) {
+        noteDequeued(p, false);
         packetPool.release(p); // free the packet we just removed
+    }
 
     bool result = (p != NULL);
     LOG_DEBUG("cancelSending id=0x%x, removed=%d\n", id, result);
     return result;
 }
 
+void RadioLibInterface::noteQueued(const meshtastic_MeshPacket *p)
+{
+    // A packet the queue replaced with a higher priority one leaves a stale entry behind, so reuse the oldest if we must
+    uint32_t now = millis();
+    QueuedPacket *slot = &queuedPackets[0];
+    for (QueuedPacket &q : queuedPackets) {
+        if (q.packet == p) {
+            slot = &q;
+            break;
+        }
+        if (!q.packet || (slot->packet && now - q.queuedMsec > now - slot->queuedMsec))
+            slot = &q;
+    }
+    *slot = {p, now};
+}
+
+void RadioLibInterface::noteDequeued(const meshtastic_MeshPacket *p, bool sending)
+{
+    for (QueuedPacket &q : queuedPackets) {
+        if (q.packet == p) {
+            if (sending) {
+                uint32_t waited = millis() - q.queuedMsec;
+                stats.txQueueWaitMsec += waited;
+                stats.txQueueWaitMaxMsec = max(stats.txQueueWaitMaxMsec, waited);
+            }
+            q.packet = NULL;
+            return;
+        }
+    }
+}
+
 /** radio helper thread callback.
 We never immediately transmit after any operation (either Rx or Tx). Instead we should wait a random multiple of
 'slotTimes' (see definition in RadioInterface.h) taken from a contention window (CW) to lower the chance of collision.
@@ -217,28 +255,42 @@ void RadioLibInterface::onNotify(uint32_t notification)
 
         // If we are not currently in receive mode, then restart the random delay (this can happen if the main thread
         // has placed the unit into standby)  FIXME, how will this work if the chipset is in sleep mode?
-        if (!txQueue.empty()) {
+        if (wantToTransmit()) {
             if (!canSendImmediately()) {
                 // LOG_DEBUG("Currently Rx/Tx-ing: set random delay\n");
+                backoff.noteDeferred();
                 setTransmitDelay(); // currently Rx/Tx-ing: reset random delay
             } else {
+                if (!lbtStartMsec)
+                    lbtStartMsec = millis();
+                stats.cadScans++;
                 if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
                     // LOG_DEBUG("Channel is active, try receiving first.\n");
+                    stats.channelActiveDeferrals++;
+                    backoff.noteDeferred();
                     startReceive(); // try receiving this packet, afterwards we'll be trying to transmit again
-                    setTransmitDelay();
+                    retryChannelActive();
+                } else if (helloWanted()) {
+                    noteChannelClear();
+                    sendHello(); // The queue gets its turn once this is done
                 } else {
+                    noteChannelClear();
+
                     // Send any outgoing packets we have ready
                     meshtastic_MeshPacket *txp = txQueue.dequeue();
                     assert(txp);
+                    noteDequeued(txp, true);
                     startSend(txp);
 
                     // Packet has been sent, count it toward our TX airtime utilization.
-                    uint32_t xmitMsec = getPacketTime(txp);
+                    uint32_t xmitMsec = getPacketTime(sendingLength);
                     airTime->logAirtime(TX_LOG, xmitMsec);
                 }
             }
         } else {
             // LOG_DEBUG("done with txqueue\n");
+            lbtRetries = 0;
+            lbtStartMsec = 0;
         }
         break;
     default:
@@ -257,7 +309,7 @@ void RadioLibInterface::setTransmitDelay()
      *   This assumption is valid because of the offset generated by the radio to account for the noise
      *   floor.
      */
-    if (p->rx_snr == 0 && p->rx_rssi == 0) {
+    if (!p || (p->rx_snr == 0 && p->rx_rssi == 0)) { // No packet means only a hello is waiting
         startTransmitTimer(true);
     } else {
         // If there is a SNR, start a timer scaled based on that SNR.
@@ -269,8 +321,8 @@ void RadioLibInterface::setTransmitDelay()
 void RadioLibInterface::startTransmitTimer(bool withDelay)
 {
     // If we have work to do and the timer wasn't already scheduled, schedule it now
-    if (!txQueue.empty()) {
-        uint32_t delay = !withDelay ? 1 : getTxDelayMsec();
+    if (wantToTransmit()) {
+        uint32_t delay = !withDelay ? 1 : alignToSlot(getTxDelayMsec());
         // LOG_DEBUG("xmit timer %d\n", delay);
         notifyLater(delay, TRANSMIT_DELAY_COMPLETED, false); // This will implicitly enable
     }
@@ -279,20 +331,64 @@ void RadioLibInterface::startTransmitTimer(bool withDelay)
 void RadioLibInterface::startTransmitTimerSNR(float snr)
 {
     // If we have work to do and the timer wasn't already scheduled, schedule it now
-    if (!txQueue.empty()) {
-        uint32_t delay = getTxDelayMsecWeighted(snr);
+    if (wantToTransmit()) {
+        uint32_t delay = alignToSlot(getTxDelayMsecWeighted(snr));
         // LOG_DEBUG("xmit timer %d\n", delay);
         notifyLater(delay, TRANSMIT_DELAY_COMPLETED, false); // This will implicitly enable
     }
 }
 
+uint32_t RadioLibInterface::alignToSlot(uint32_t delay)
+{
+    // Nodes that heard the same frame end count their slots from the same moment, so keeping to the slot grid means
+    // a node that picked a later slot has a whole slot to hear the one that picked an earlier one
+    uint32_t slotTime = getSlotTimeMsec();
+    uint32_t idleSince = max(stats.lastRxDoneMsec, stats.lastTxDoneMsec);
+    if (!idleSince || !slotTime)
+        return delay;
+
+    uint32_t offset = (millis() + delay - idleSince) % slotTime;
+    return offset ? delay + slotTime - offset : delay;
+}
+
+void RadioLibInterface::retryChannelActive()
+{
+    if (lbtRetries < LBT_MAX_CAD_RETRIES) {
+        // If the frame we heard is short, or not LoRa traffic of ours at all, the channel frees up long before a whole new
+        // contention window would have us check again. A frame we can decode restarts the timer once it is received.
+        lbtRetries++;
+        stats.lbtRetries++;
+        uint32_t slots = random(1, (1 << lbtRetries) + 1);
+        notifyLater(alignToSlot(slots * getSlotTimeMsec()), TRANSMIT_DELAY_COMPLETED, false);
+    } else {
+        lbtRetries = 0;
+        stats.lbtRedraws++;
+        setTransmitDelay();
+    }
+}
+
+void RadioLibInterface::noteChannelClear()
+{
+    uint32_t waited = millis() - lbtStartMsec;
+    stats.lbtWaitMsec += waited;
+    stats.lbtWaitMaxMsec = max(stats.lbtWaitMaxMsec, waited);
+    lbtRetries = 0;
+    lbtStartMsec = 0;
+}
+
 void RadioLibInterface::handleTransmitInterrupt()
 {
     // LOG_DEBUG("handling lora TX interrupt\n");
     // This can be null if we forced the device to enter standby mode.  In that case
     // ignore the transmit interrupt
-    if (sendingPacket)
+    if (sendingPacket || sendingHello) {
+        uint32_t now = millis();
+        stats.txGood++;
+        backoff.noteSuccess();
+        stats.txAirtimeMsec += now - lastTxStart;
+        stats.lastTxDoneMsec = now;
         completeSending();
+    }
 }
 
 void RadioLibInterface::completeSending()
@@ -301,9 +397,9 @@ void RadioLibInterface::completeSending()
     // that can take a long time
     auto p = sendingPacket;
     sendingPacket = NULL;
+    sendingHello = false;
 
     if (p) {
-        txGood++;
         printPacket("Completed sending", p);
 
         // We are done sending that packet, release it
@@ -324,67 +420,95 @@ void RadioLibInterface::handleReceiveInterrupt()
     }
 
     isReceiving = false;
+    stats.lastRxDoneMsec = millis();
 
     // read the number of actually received bytes
     size_t length = iface->getPacketLength();
 
     xmitMsec = getPacketTime(length);
+    stats.rxAirtimeMsec += xmitMsec;
 
-    int state = iface->readData(radiobuf, length);
+    // Read straight into the router's ring of received frames, if it has room
+    RadioFrame *frame = router ? router->beginReceivedFrame() : NULL;
+    uint8_t *buf = frame ? frame->bytes : radiobuf;
+
+    int state = iface->readData(buf, length);
     if (state != RADIOLIB_ERR_NONE) {
         LOG_ERROR("ignoring received packet due to error=%d\n", state);
-        rxBad++;
+        if (state == RADIOLIB_ERR_CRC_MISMATCH)
+            stats.rxCrcErrors++;
+        else
+            stats.rxOtherErrors++;
 
         airTime->logAirtime(RX_ALL_LOG, xmitMsec);
 
     } else {
         // Skip the 4 headers that are at the beginning of the rxBuf
         int32_t payloadLen = length - sizeof(PacketHeader);
-        const uint8_t *payload = radiobuf + sizeof(PacketHeader);
 
         // check for short packets
         if (payloadLen < 0) {
             LOG_WARN("ignoring received packet too short\n");
-            rxBad++;
+            stats.rxTooShort++;
             airTime->logAirtime(RX_ALL_LOG, xmitMsec);
         } else {
-            const PacketHeader *h = (PacketHeader *)radiobuf;
-            rxGood++;
+            const PacketHeader *h = (PacketHeader *)buf;
             // altered packet with "from == 0" can do Remote Node Administration without permission
             if (h->from == 0) {
                 LOG_WARN("ignoring received packet without sender\n");
+                stats.rxNoSender++;
                 return;
             }
 
-            // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
-            // This allows the router and other apps on our node to sniff packets (usually routing) between other
-            // nodes.
-            meshtastic_MeshPacket *mp = packetPool.allocZeroed();
-
-            mp->from = h->from;
-            mp->to = h->to;
-            mp->id = h->id;
-            mp->channel = h->channel;
-            assert(HOP_MAX <= PACKET_FLAGS_HOP_LIMIT_MASK); // If hopmax changes, carefully check this code
-            mp->hop_limit = h->flags & PACKET_FLAGS_HOP_LIMIT_MASK;
-            mp->hop_start = (h->flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
-            mp->want_ack = !!(h->flags & PACKET_FLAGS_WANT_ACK_MASK);
-            mp->via_mqtt = !!(h->flags & PACKET_FLAGS_VIA_MQTT_MASK);
-
-            addReceiveMetadata(mp);
+            airTime->logAirtime(RX_LOG, xmitMsec);
 
-            mp->which_payload_variant =
-                meshtastic_MeshPacket_encrypted_tag; // Mark that the payload is still encrypted at this point
-            assert(((uint32_t)payloadLen) <= sizeof(mp->encrypted.bytes));
-            memcpy(mp->encrypted.bytes, payload, payloadLen);
-            mp->encrypted.size = payloadLen;
+            if (FrameAggregator::isAggregate(buf, length)) {
+                stats.rxGood++;
+                receiveBundle(buf, length, frame);
+                return;
+            }
 
-            printPacket("Lora RX", mp);
+            if (!frame) {
+                LOG_WARN("ignoring received packet, the router hasn't caught up\n");
+                return;
+            }
 
-            airTime->logAirtime(RX_LOG, xmitMsec);
+            // The router parses the header and allocates the packet once it gets to this frame
+            stats.rxGood++;
+            frame->length = length;
+            frame->rxMsec = stats.lastRxDoneMsec;
+            addReceiveMetadata(frame);
+            router->commitReceivedFrame();
+        }
+    }
+}
 
-            deliverToReceiver(mp);
+void RadioLibInterface::receiveBundle(const uint8_t *buf, size_t length, RadioFrame *frame)
+{
+    // buf is the first ring slot we fill, so work from a copy
+    uint8_t bundle[MAX_RHPACKETLEN];
+    memcpy(bundle, buf, length);
+
+    const PacketHeader *h = (PacketHeader *)bundle;
+    aggregator.noteCapable(h->from);
+
+    size_t offset = 0, packetLen;
+    const uint8_t *packet;
+    while (FrameAggregator::next(bundle, length, offset, packet, packetLen)) {
+        if (((const PacketHeader *)packet)->from == 0) {
+            stats.rxNoSender++;
+            continue;
         }
+        if (!frame && !(router && (frame = router->beginReceivedFrame()))) {
+            LOG_WARN("dropping the rest of a bundle from 0x%x, the router hasn't caught up\n", h->from);
+            return;
+        }
+        memcpy(frame->bytes, packet, packetLen);
+        frame->length = packetLen;
+        frame->rxMsec = stats.lastRxDoneMsec;
+        addReceiveMetadata(frame);
+        router->commitReceivedFrame();
+        frame = NULL;
     }
 }
 
@@ -395,19 +519,27 @@ void RadioLibInterface::startSend(meshtastic_MeshPacket *txp)
     if (disabled || !config.lora.tx_enabled) {
         LOG_WARN("startSend is dropping tx packet because we are disabled\n");
         packetPool.release(txp);
+        sendingLength = 0;
     } else {
         configHardwareForSend(); // must be after setStandby
 
         size_t numbytes = beginSending(txp);
+        if (FRAME_AGGREGATION)
+            numbytes = bundleQueued(numbytes);
+        sendingLength = numbytes;
 
         int res = iface->startTransmit(radiobuf, numbytes);
         if (res != RADIOLIB_ERR_NONE) {
             LOG_ERROR("startTransmit failed, error=%d\n", res);
+            stats.txFailed++;
             RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_RADIO_SPI_BUG);
 
             // This send failed, but make sure to 'complete' it properly
+            finishBundle(false);
             completeSending();
             startReceive(); // Restart receive mode (because startTransmit failed to put us in xmit mode)
+        } else {
+            finishBundle(true);
         }
 
         // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register
@@ -415,3 +547,87 @@ void RadioLibInterface::startSend(meshtastic_MeshPacket *txp)
         enableInterrupt(isrTxLevel0);
     }
 }
+
+size_t RadioLibInterface::bundleQueued(size_t numbytes)
+{
+    if (txQueue.empty() || !aggregator.neighborsCapable())
+        return numbytes;
+
+    uint8_t bundle[MAX_RHPACKETLEN];
+    size_t len = aggregator.begin(bundle, nodeDB->getNodeNum());
+    if (!aggregator.fits(bundle, len, numbytes))
+        return numbytes;
+    aggregator.add(bundle, len, radiobuf, numbytes);
+
+    // Only our own packets go along. Rebroadcasts wait out their own SNR weighted delay, hearing someone else relay the
+    // packet first in that time may cancel them
+    uint8_t packet[MAX_RHPACKETLEN];
+    meshtastic_MeshPacket *next;
+    size_t space;
+    while ((space = aggregator.spaceLeft(bundle, len)) > sizeof(PacketHeader) &&
+           (next = txQueue.dequeueFrom(nodeDB->getNodeNum(), space - sizeof(PacketHeader))) != NULL) {
+        noteDequeued(next, true);
+        size_t packetLen = encodeFrame(next, packet);
+        aggregator.add(bundle, len, packet, packetLen);
+        printPacket("Bundling", next);
+        bundled[numBundled++] = next;
+    }
+
+    if (!numBundled)
+        return numbytes; // Nothing else fit, so don't pay for the bundle headers
+
+    memcpy(radiobuf, bundle, len);
+    aggregator.noteHelloSent(); // A bundle tells our neighbors as much as a hello
+    return len;
+}
+
+void RadioLibInterface::finishBundle(bool sent)
+{
+    for (size_t i = 0; i < numBundled; i++) {
+        if (sent) {
+            packetPool.release(bundled[i]);
+        } else if (txQueue.enqueue(bundled[i])) {
+            noteQueued(bundled[i]);
+        } else {
+            packetPool.release(bundled[i]);
+        }
+    }
+    numBundled = 0;
+}
+
+bool RadioLibInterface::helloWanted()
+{
+    if (!aggregator.helloDue() || disabled || !config.lora.tx_enabled ||
+        config.lora.region == meshtastic_Config_LoRaConfig_RegionCode_UNSET)
+        return false;
+
+    // Hellos are extra airtime, so they give way like our other periodic broadcasts. A skipped one waits a full period
+    if (config.device.role == meshtastic_Config_DeviceConfig_Role_CLIENT_HIDDEN || config.power.is_power_saving ||
+        (airTime && (!airTime->isTxAllowedAirUtil() || !airTime->isTxAllowedChannelUtil(true)))) {
+        aggregator.noteHelloSent();
+        return false;
+    }
+    return true;
+}
+
+void RadioLibInterface::sendHello()
+{
+    LOG_DEBUG("Sending frame aggregation hello\n");
+    configHardwareForSend();
+
+    size_t numbytes = aggregator.begin(radiobuf, nodeDB->getNodeNum());
+    aggregator.noteHelloSent();
+    lastTxStart = millis();
+    sendingHello = true;
+
+    int res = iface->startTransmit(radiobuf, numbytes);
+    if (res != RADIOLIB_ERR_NONE) {
+        LOG_ERROR("startTransmit failed, error=%d\n", res);
+        stats.txFailed++;
+        completeSending();
+        startReceive();
+    } else {
+        airTime->logAirtime(TX_LOG, getPacketTime(numbytes));
+    }
+    enableInterrupt(isrTxLevel0);
+}
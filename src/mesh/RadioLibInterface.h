@@ -1,6 +1,8 @@
 #pragma once
 
+#include "FrameAggregator.h"
 #include "MeshPacketQueue.h"
+#include "RadioFrameRing.h"
 #include "RadioInterface.h"
 #include "concurrency/NotifiedWorkerThread.h"
 
@@ -15,6 +17,49 @@
 
 #define RADIOLIB_PIN_TYPE uint32_t
 
+/// How many short, slot aligned retries we make when channel activity detection hears a preamble before we draw a new
+/// contention window
+#ifndef LBT_MAX_CAD_RETRIES
+#define LBT_MAX_CAD_RETRIES 4
+#endif
+
+/**
+ * What our radio saw and did, so hop limits and modem presets can be tuned from data. Times are millis().
+ *
+ * The radios only interrupt us on RX/TX done, the preamble and header flags are seen when we poll them before
+ * transmitting. RadioLib reports header CRC errors the same way as payload CRC errors, so rxCrcErrors counts both.
+ */
+struct RadioStats {
+    uint32_t rxGood;         // Frames we read and handed to the router
+    uint32_t rxCrcErrors;    // Frames the radio received, but failed their CRC
+    uint32_t rxOtherErrors;  // Frames we couldn't read for another reason
+    uint32_t rxTooShort;     // Frames shorter than our PacketHeader
+    uint32_t rxNoSender;     // Frames with from == 0
+    uint32_t falsePreambles; // Preambles we saw that no valid header followed
+    uint32_t falseHeaders;   // Valid headers we saw that no RX done followed
+
+    uint32_t txGood;                 // Transmissions the radio finished
+    uint32_t txFailed;               // Transmissions the radio wouldn't start
+    uint32_t busyRxDeferrals;        // Transmit attempts put off because we were in the middle of receiving
+    uint32_t busyTxDeferrals;        // Transmit attempts put off because we were still transmitting
+    uint32_t channelActiveDeferrals; // Transmit attempts put off because channel activity detection heard a preamble
+    uint32_t cadScans;               // Channel activity detections we ran before transmitting
+    uint32_t lbtRetries;             // Slot aligned retries after channel activity detection heard a preamble
+    uint32_t lbtRedraws;             // Times we ran out of those retries and drew a whole new contention window
+
+    uint32_t rxAirtimeMsec;      // Airtime of the frames we received, from their length
+    uint32_t txAirtimeMsec;      // Airtime of our transmissions, measured from starting them to the TX done interrupt
+    uint32_t txQueueWaitMsec;    // Total time the packets we transmitted waited in our queue
+    uint32_t txQueueWaitMaxMsec; // Longest any of them waited
+    uint32_t lbtWaitMsec;        // Total time from our first channel activity detection for a frame to transmitting it
+    uint32_t lbtWaitMaxMsec;     // Longest any frame waited that way
+
+    uint32_t lastPreambleMsec; // When we last saw a preamble, header, RX done or TX done. 0 if never
+    uint32_t lastHeaderMsec;
+    uint32_t lastRxDoneMsec;
+    uint32_t lastTxDoneMsec;
+};
+
 /**
  * We need to override the RadioLib ArduinoHal class to add mutex protection for SPI bus access
  */
@@ -53,13 +98,30 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     static void isrTxLevel0(), isrLevel0Common(PendingISR code);
 
-    /**
-     * Debugging counts
-     */
-    uint32_t rxBad = 0, rxGood = 0, txGood = 0;
-
     MeshPacketQueue txQueue = MeshPacketQueue(MAX_TX_QUEUE);
 
+    /// When the packets in txQueue were queued, for RadioStats::txQueueWaitMsec
+    struct QueuedPacket {
+        const meshtastic_MeshPacket *packet;
+        uint32_t queuedMsec;
+    };
+    QueuedPacket queuedPackets[MAX_TX_QUEUE] = {};
+
+    void noteQueued(const meshtastic_MeshPacket *p);
+    /// Forget when p was queued, and count how long it waited if we're about to transmit it
+    void noteDequeued(const meshtastic_MeshPacket *p, bool sending);
+
+    FrameAggregator aggregator;
+    bool sendingHello = false; // Are we transmitting a hello rather than sendingPacket?
+    size_t sendingLength = 0;  // Length of the frame we last started transmitting
+
+    // Packets bundled with sendingPacket, kept until their frame is on its way
+    meshtastic_MeshPacket *bundled[FRAME_AGGREGATION_MAX_PACKETS - 1] = {};
+    size_t numBundled = 0;
+
+    uint8_t lbtRetries = 0;    // Slot aligned retries made for the frame we are trying to send
+    uint32_t lbtStartMsec = 0; // When we first checked the channel for it, 0 if we haven't yet
+
   protected:
     /**
      * We use a meshtastic sync word, but hashed with the Channel name.  For releases before 1.2 we used 0x12 (or for very old
@@ -86,6 +148,8 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /// are _trying_ to receive a packet currently (note - we might just be waiting for one)
     bool isReceiving = false;
 
+    RadioStats stats = {};
+
   public:
     /** Our ISR code currently needs this to find our active instance
      */
@@ -132,6 +196,8 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
     virtual bool cancelSending(NodeNum from, PacketId id) override;
 
+    const RadioStats &getStats() const { return stats; }
+
   private:
     /** if we have something waiting to send, start a short (random) timer so we can come check for collision before actually
      * doing the transmit */
@@ -143,6 +209,15 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /** timer scaled to SNR of to be flooded packet */
     void startTransmitTimerSNR(float snr);
 
+    /** Round a delay up so we transmit on a slot boundary, counting slots from when the channel last went quiet */
+    uint32_t alignToSlot(uint32_t delay);
+
+    /** channel activity detection heard a preamble: check again a few slots later, or draw a new contention window */
+    void retryChannelActive();
+
+    /** channel activity detection found the channel clear, we are about to transmit */
+    void noteChannelClear();
+
     void handleTransmitInterrupt();
     void handleReceiveInterrupt();
 
@@ -155,6 +230,25 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     virtual void startSend(meshtastic_MeshPacket *txp);
 
+    /// Move more of our own packets from txQueue into the frame in radiobuf, if our neighbors can unbundle it. Returns the
+    /// new length
+    size_t bundleQueued(size_t numbytes);
+
+    /// The bundled packets are on their way (release them), or aren't (queue them again)
+    void finishBundle(bool sent);
+
+    /// Is it time to tell our neighbors that we can unbundle frames?
+    bool helloWanted();
+
+    /// Tell our neighbors that we can unbundle frames
+    void sendHello();
+
+    /// Do we have packets queued, or a hello to send?
+    bool wantToTransmit() { return !txQueue.empty() || helloWanted(); }
+
+    /// Hand each packet in a bundle to the router as if it had arrived on its own
+    void receiveBundle(const uint8_t *buf, size_t length, RadioFrame *frame);
+
     meshtastic_QueueStatus getQueueStatus();
 
   protected:
@@ -176,7 +270,7 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /**
      * Add SNR data to received messages
      */
-    virtual void addReceiveMetadata(meshtastic_MeshPacket *mp) = 0;
+    virtual void addReceiveMetadata(RadioFrame *frame) = 0;
 
     virtual void setStandby() = 0;
 };
@@ -27,13 +27,19 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
     /* If we have pending retransmissions, add the airtime of this packet to it, because during that time we cannot receive an
        (implicit) ACK. Otherwise, we might retransmit too early.
      */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        if (i->first.id != p->id) {
-            i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty()) {
+        uint32_t airtime = iface->getPacketTime(p);
+        retransmissionDelayMsec += airtime;
+
+        // Except for the packet we are sending now, that one keeps its deadline
+        auto sent = findPendingPacket(GlobalPacketId(p));
+        if (sent) {
+            sent->nextTxMsec -= airtime;
+            scheduleRetransmission(*sent);
         }
     }
 
-    return FloodingRouter::send(p);
+    return NextHopRouter::send(p);
 }
 
 bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
@@ -67,23 +73,36 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
        because while receiving this packet, we could not have received an (implicit) ACK for it.
        If we don't add this, we will likely retransmit too early.
     */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        i->second.nextTxMsec += iface->getPacketTime(p);
-    }
+    if (!pending.empty())
+        retransmissionDelayMsec += iface->getPacketTime(p);
 
     /* Resend implicit ACKs for repeated packets (hopStart equals hopLimit);
      * this way if an implicit ACK is dropped and a packet is resent we'll rebroadcast again.
      * Resending real ACKs is omitted, as you might receive a packet multiple times due to flooding and
      * flooding this ACK back to the original sender already adds redundancy. */
-    bool isRepeated = p->hop_start == 0 ? (p->hop_limit == HOP_RELIABLE) : (p->hop_start == p->hop_limit);
-    if (wasSeenRecently(p, false) && isRepeated && !MeshModule::currentReply && p->to != nodeDB->getNodeNum()) {
+    if (wasSeenRecently(p, false) && isRepeated(p) && !MeshModule::currentReply && p->to != nodeDB->getNodeNum()) {
         LOG_DEBUG("Resending implicit ack for a repeated floodmsg\n");
         meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p);
         tosend->hop_limit--; // bump down the hop count
         Router::send(tosend);
     }
 
-    return FloodingRouter::shouldFilterReceived(p);
+    return NextHopRouter::shouldFilterReceived(p);
+}
+
+bool ReliableRouter::shouldDropDuplicate(const meshtastic_MeshPacket *p)
+{
+    // Someone rebroadcasting for us is an implicit ack, and a repeated flood can need ours resent: both need the whole packet
+    if (p->from == getNodeNum() || (isRepeated(p) && p->to != nodeDB->getNodeNum()))
+        return false;
+
+    if (!NextHopRouter::shouldDropDuplicate(p))
+        return false;
+
+    // We couldn't have heard an ack while receiving it either, see shouldFilterReceived()
+    if (!pending.empty())
+        retransmissionDelayMsec += iface->getPacketTime(p);
+    return true;
 }
 
 /**
@@ -134,7 +153,7 @@ void ReliableRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
     }
 
     // handle the packet as normal
-    FloodingRouter::sniffReceived(p, c);
+    NextHopRouter::sniffReceived(p, c);
 }
 
 #define NUM_RETRANSMISSIONS 3
@@ -203,57 +222,70 @@ PendingPacket *ReliableRouter::startRetransmission(meshtastic_MeshPacket *p)
  */
 int32_t ReliableRouter::doRetransmissions()
 {
-    uint32_t now = millis();
-    int32_t d = INT32_MAX;
+    uint32_t now = retransmissionNow();
 
-    // FIXME, we should use a better datastructure rather than walking through this map.
-    // for(auto el: pending) {
-    for (auto it = pending.begin(), nextIt = it; it != pending.end(); it = nextIt) {
-        ++nextIt; // we use this odd pattern because we might be deleting it...
-        auto &p = it->second;
-
-        bool stillValid = true; // assume we'll keep this record around
-
-        // FIXME, handle 51 day rolloever here!!!
-        if (p.nextTxMsec <= now) {
-            if (p.numRetransmissions == 0) {
-                LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x\n", p.packet->from, p.packet->to,
-                          p.packet->id);
-                sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
-                // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
-                stopRetransmission(it->first);
-                stillValid = false; // just deleted it
-            } else {
-                LOG_DEBUG("Sending reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d\n", p.packet->from,
-                          p.packet->to, p.packet->id, p.numRetransmissions);
+    // Stale entries are normally dropped as they come due, but don't let a burst of acks leave lots of them behind
+    if (retransmissionQueue.size() > 2 * pending.size() + 8) {
+        retransmissionQueue = std::priority_queue<ScheduledRetransmission>();
+        for (auto &i : pending)
+            scheduleRetransmission(i.second);
+    }
 
-                // Note: we call the superclass version because we don't want to have our version of send() add a new
-                // retransmission record
-                FloodingRouter::send(packetPool.allocCopy(*p.packet));
+    while (!retransmissionQueue.empty()) {
+        ScheduledRetransmission next = retransmissionQueue.top();
 
-                // Queue again
-                --p.numRetransmissions;
-                setNextTx(&p);
-            }
+        auto it = pending.find(next.id);
+        if (it == pending.end() || it->second.nextTxMsec != next.dueMsec) {
+            retransmissionQueue.pop(); // Acked, or rescheduled since
+            continue;
         }
 
-        if (stillValid) {
-            // Update our desired sleep delay
-            int32_t t = p.nextTxMsec - now;
+        int32_t t = next.dueMsec - now;
+        if (t > 0)
+            return t; // Nothing else is due yet
+        retransmissionQueue.pop();
+
+        auto &p = it->second;
+        if (p.numRetransmissions == 0) {
+            LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x\n", p.packet->from, p.packet->to,
+                      p.packet->id);
+            sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
+            // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
+            stopRetransmission(next.id);
+        } else {
+            LOG_DEBUG("Sending reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d\n", p.packet->from, p.packet->to,
+                      p.packet->id, p.numRetransmissions);
+
+            // Flood it this time, in case the relay we picked is the problem
+            noteRouteFailure(p.packet);
+            if (iface)
+                iface->noteTxCollision(); // Back off further before we transmit again
 
-            d = min(t, d);
+            // Note: we call the superclass version because we don't want to have our version of send() add a new
+            // retransmission record
+            NextHopRouter::send(packetPool.allocCopy(*p.packet));
+
+            // Queue again
+            --p.numRetransmissions;
+            setNextTx(&p);
         }
     }
 
-    return d;
+    return INT32_MAX;
 }
 
 void ReliableRouter::setNextTx(PendingPacket *pending)
 {
     assert(iface);
     auto d = iface->getRetransmissionMsec(pending->packet);
-    pending->nextTxMsec = millis() + d;
+    pending->nextTxMsec = retransmissionNow() + d;
+    scheduleRetransmission(*pending);
     LOG_DEBUG("Setting next retransmission in %u msecs: ", d);
     printPacket("", pending->packet);
     setReceivedMessage(); // Run ASAP, so we can figure out our correct sleep time
-}
\ No newline at end of file
+}
+
+void ReliableRouter::scheduleRetransmission(const PendingPacket &pending)
+{
+    retransmissionQueue.push({pending.nextTxMsec, GlobalPacketId(pending.packet)});
+}
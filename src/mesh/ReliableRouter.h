@@ -1,7 +1,9 @@
 #pragma once
 
-#include "FloodingRouter.h"
+#include "NextHopRouter.h"
+#include <queue>
 #include <unordered_map>
+#include <vector>
 
 /**
  * An identifier for a globalally unique message - a pair of the sending nodenum and the packet id assigned
@@ -32,7 +34,7 @@ struct GlobalPacketId {
 struct PendingPacket {
     meshtastic_MeshPacket *packet;
 
-    /** The next time we should try to retransmit this packet */
+    /** The next time we should try to retransmit this packet, on ReliableRouter's retransmission clock */
     uint32_t nextTxMsec = 0;
 
     /** Starts at NUM_RETRANSMISSIONS -1(normally 3) and counts down.  Once zero it will be removed from the list */
@@ -48,14 +50,38 @@ class GlobalPacketIdHashFunction
     size_t operator()(const GlobalPacketId &p) const { return (std::hash<NodeNum>()(p.node)) ^ (std::hash<PacketId>()(p.id)); }
 };
 
+/**
+ * A deadline in the retransmission queue. Entries are never removed from the middle of the queue, so one is stale (and
+ * skipped) once its packet is no longer pending or has been rescheduled to a different nextTxMsec.
+ */
+struct ScheduledRetransmission {
+    uint32_t dueMsec;
+    GlobalPacketId id;
+
+    /// Orders the queue soonest first. Wrap safe, as long as deadlines are within 24 days of each other
+    bool operator<(const ScheduledRetransmission &other) const { return (int32_t)(dueMsec - other.dueMsec) > 0; }
+};
+
 /**
  * This is a mixin that extends Router with the ability to do (one hop only) reliable message sends.
  */
-class ReliableRouter : public FloodingRouter
+class ReliableRouter : public NextHopRouter
 {
   private:
     std::unordered_map<GlobalPacketId, PendingPacket, GlobalPacketIdHashFunction> pending;
 
+    /// Deadlines of the pending packets, soonest on top, so each run only looks at the ones that are due
+    std::priority_queue<ScheduledRetransmission> retransmissionQueue;
+
+    /**
+     * Total airtime that every pending retransmission has been pushed back by. Deadlines are kept on a clock of
+     * millis() minus this, so pushing them all back is just adding to it.
+     */
+    uint32_t retransmissionDelayMsec = 0;
+
+    /// The retransmission clock that nextTxMsec is kept on
+    uint32_t retransmissionNow() const { return millis() - retransmissionDelayMsec; }
+
   public:
     /**
      * Constructor
@@ -76,7 +102,7 @@ class ReliableRouter : public FloodingRouter
         // Note: We must doRetransmissions FIRST, because it might queue up work for the base class runOnce implementation
         auto d = doRetransmissions();
 
-        int32_t r = FloodingRouter::runOnce();
+        int32_t r = NextHopRouter::runOnce();
 
         return min(d, r);
     }
@@ -98,12 +124,21 @@ class ReliableRouter : public FloodingRouter
      */
     virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) override;
 
+    /// Duplicates that need no implicit ack handling can be dropped from their header, as NextHopRouter does
+    virtual bool shouldDropDuplicate(const meshtastic_MeshPacket *p) override;
+
     /**
      * Add p to the list of packets to retransmit occasionally.  We will free it once we stop retransmitting.
      */
     PendingPacket *startRetransmission(meshtastic_MeshPacket *p);
 
   private:
+    /// Did we hear this straight from its sender, i.e. is the sender repeating it (hopStart equals hopLimit)?
+    static bool isRepeated(const meshtastic_MeshPacket *p)
+    {
+        return p->hop_start == 0 ? (p->hop_limit == HOP_RELIABLE) : (p->hop_start == p->hop_limit);
+    }
+
     /**
      * Stop any retransmissions we are doing of the specified node/packet ID pair
      *
@@ -120,4 +155,7 @@ class ReliableRouter : public FloodingRouter
     int32_t doRetransmissions();
 
     void setNextTx(PendingPacket *pending);
+
+    /// Add a pending packet's current nextTxMsec to the retransmission queue
+    void scheduleRetransmission(const PendingPacket &pending);
 };
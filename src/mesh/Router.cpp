@@ -7,6 +7,7 @@
 #include "configuration.h"
 #include "main.h"
 #include "mesh-pb-constants.h"
+#include "mesh/compression/PayloadCompression.h"
 #include "modules/RoutingModule.h"
 #if !MESHTASTIC_EXCLUDE_MQTT
 #include "mqtt/MQTT.h"
@@ -62,6 +63,13 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
  */
 int32_t Router::runOnce()
 {
+    // Everything our radio received since we last ran, in the order it arrived
+    const RadioFrame *frame;
+    while ((frame = fromRadioFrames.peek()) != NULL) {
+        handleReceivedFrame(*frame);
+        fromRadioFrames.pop();
+    }
+
     meshtastic_MeshPacket *mp;
     while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
         // printPacket("handle fromRadioQ", mp);
@@ -239,8 +247,14 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     p->from = getFrom(p);
 
     // If we are the original transmitter, set the hop limit with which we start
-    if (p->from == getNodeNum())
+    if (p->from == getNodeNum()) {
+        uint8_t hopLimit = hopLimits.getHopLimit(p->to, p->hop_limit);
+        if (hopLimit != p->hop_limit) {
+            LOG_DEBUG("0x%x is close by, sending 0x%x with hop limit %d instead of %d\n", p->to, p->id, hopLimit, p->hop_limit);
+            p->hop_limit = hopLimit;
+        }
         p->hop_start = p->hop_limit;
+    }
 
     // If the packet hasn't yet been encrypted, do so now (it might already be encrypted if we are just forwarding it)
 
@@ -329,25 +343,9 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
                 p->which_payload_variant = meshtastic_MeshPacket_decoded_tag; // change type to decoded
                 p->channel = chIndex;                                         // change to store the index instead of the hash
 
-                /* Not actually ever used.
-                // Decompress if needed. jm
-                if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP) {
-                    // Decompress the payload
-                    char compressed_in[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
-                    char decompressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
-                    int decompressed_len;
-
-                    memcpy(compressed_in, p->decoded.payload.bytes, p->decoded.payload.size);
-
-                    decompressed_len = unishox2_decompress_simple(compressed_in, p->decoded.payload.size, decompressed_out);
-
-                    // LOG_DEBUG("\n\n**\n\nDecompressed length - %d \n", decompressed_len);
-
-                    memcpy(p->decoded.payload.bytes, decompressed_out, decompressed_len);
-
-                    // Switch the port from PortNum_TEXT_MESSAGE_COMPRESSED_APP to PortNum_TEXT_MESSAGE_APP
-                    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-                } */
+                // A payload we can't decompress is still handed on as it arrived, like before we decompressed at all
+                if (!PayloadCompression::decompress(p->decoded))
+                    LOG_WARN("Can't decompress the payload on portnum %d, leaving it compressed\n", p->decoded.portnum);
 
                 printPacket("decoded message", p);
                 return true;
@@ -367,43 +365,14 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
 
     // If the packet is not yet encrypted, do so now
     if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
-        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
-
-        /* Not actually used, so save the cycles
-        // Only allow encryption on the text message app.
-        //  TODO: Allow modules to opt into compression.
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
-
-            char original_payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
-            memcpy(original_payload, p->decoded.payload.bytes, p->decoded.payload.size);
-
-            char compressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
-
-            int compressed_len;
-            compressed_len = unishox2_compress_simple(original_payload, p->decoded.payload.size, compressed_out);
-
-            LOG_DEBUG("Original length - %d \n", p->decoded.payload.size);
-            LOG_DEBUG("Compressed length - %d \n", compressed_len);
-            LOG_DEBUG("Original message - %s \n", p->decoded.payload.bytes);
-
-            // If the compressed length is greater than or equal to the original size, don't use the compressed form
-            if (compressed_len >= p->decoded.payload.size) {
-
-                LOG_DEBUG("Not using compressing message.\n");
-                // Set the uncompressed payload variant anyway. Shouldn't hurt?
-                // p->decoded.which_payloadVariant = Data_payload_tag;
-
-                // Otherwise we use the compressor
-            } else {
-                LOG_DEBUG("Using compressed message.\n");
-                // Copy the compressed data into the meshpacket
-
-                p->decoded.payload.size = compressed_len;
-                memcpy(p->decoded.payload.bytes, compressed_out, compressed_len);
-
-                p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP;
-            }
-        } */
+        const meshtastic_Data *data = &p->decoded;
+#if PAYLOAD_COMPRESSION
+        static meshtastic_Data compressedData; // Scratch like bytes, cryptLock covers it too
+        compressedData = p->decoded;
+        if (PayloadCompression::compress(compressedData))
+            data = &compressedData;
+#endif
+        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, data);
 
         if (numbytes > MAX_RHPACKETLEN)
             return meshtastic_Routing_Error_TOO_LARGE;
@@ -483,6 +452,65 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
     packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
+void Router::unpackHeader(const RadioFrame &frame, meshtastic_MeshPacket *p)
+{
+    const PacketHeader *h = (const PacketHeader *)frame.bytes;
+
+    p->from = h->from;
+    p->to = h->to;
+    p->id = h->id;
+    p->channel = h->channel;
+    assert(HOP_MAX <= PACKET_FLAGS_HOP_LIMIT_MASK); // If hopmax changes, carefully check this code
+    p->hop_limit = h->flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    p->hop_start = (h->flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    p->want_ack = !!(h->flags & PACKET_FLAGS_WANT_ACK_MASK);
+    p->via_mqtt = !!(h->flags & PACKET_FLAGS_VIA_MQTT_MASK);
+    p->rx_snr = frame.snr;
+    p->rx_rssi = frame.rssi;
+
+    p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag; // Mark that the payload is still encrypted at this point
+    p->encrypted.size = frame.length - sizeof(PacketHeader);
+}
+
+void Router::handleReceivedFrame(const RadioFrame &frame)
+{
+    const PacketHeader *h = (const PacketHeader *)frame.bytes;
+
+    if (is_in_repeated(config.lora.ignore_incoming, h->from) ||
+        (config.lora.ignore_mqtt && (h->flags & PACKET_FLAGS_VIA_MQTT_MASK))) {
+        LOG_DEBUG("Ignoring incoming message, 0x%x is in our ignore list or came via MQTT\n", h->from);
+        rxDrops.ignored++;
+        return;
+    }
+
+    // In a busy mesh most of what we hear is copies of packets we already have, so look at the header on its own first
+    meshtastic_MeshPacket header = meshtastic_MeshPacket_init_zero;
+    unpackHeader(frame, &header);
+    assert(header.encrypted.size <= sizeof(header.encrypted.bytes));
+
+    printPacket("Lora RX", &header);
+
+    // Every copy tells us how far away its sender is, and copies that came the short way may be about to be dropped
+    if (header.hop_start != 0 && header.hop_limit <= header.hop_start && !header.via_mqtt && header.from != getNodeNum())
+        hopLimits.noteHops(header.from, header.hop_start - header.hop_limit);
+
+    // Handling the header is synchronous, so the cache entry for our stack copy is only looked at while it's still valid
+    sniffRelayHeader(&header, h->next_hop, h->relay_node);
+    if (shouldDropDuplicate(&header)) {
+        rxDrops.duplicate++;
+        return;
+    }
+
+    // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
+    // This allows the router and other apps on our node to sniff packets (usually routing) between other
+    // nodes.
+    meshtastic_MeshPacket *mp = packetPool.allocCopy(header);
+    memcpy(mp->encrypted.bytes, frame.bytes + sizeof(PacketHeader), mp->encrypted.size);
+
+    sniffRelayHeader(mp, h->next_hop, h->relay_node);
+    perhapsHandleReceived(mp);
+}
+
 void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 {
     // assert(radioConfig.has_preferences);
@@ -490,8 +518,10 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 
     if (ignore) {
         LOG_DEBUG("Ignoring incoming message, 0x%x is in our ignore list or came via MQTT\n", p->from);
+        rxDrops.ignored++;
     } else if (ignore |= shouldFilterReceived(p)) {
         LOG_DEBUG("Incoming message was filtered 0x%x\n", p->from);
+        rxDrops.filtered++;
     }
 
     // Note: we avoid calling shouldFilterReceived if we are supposed to ignore certain nodes - because some overrides might
@@ -1,13 +1,25 @@
 #pragma once
 
 #include "Channels.h"
+#include "HopLimitOptimizer.h"
 #include "MemoryPool.h"
 #include "MeshTypes.h"
 #include "Observer.h"
 #include "PointerQueue.h"
+#include "RadioFrameRing.h"
 #include "RadioInterface.h"
 #include "concurrency/OSThread.h"
 
+/// Why received packets were dropped before they reached any module
+struct RxDropStats {
+    uint32_t routerBusy; // Frames our radio received while all RX_FRAME_RING_SIZE slots were still waiting for us
+    uint32_t ignored;    // From nodes in our ignore list, or via MQTT when we ignore that
+    uint32_t duplicate;  // Copies of packets we had already seen, dropped from their header alone
+    uint32_t filtered;   // Dropped by shouldFilterReceived() once decoded far enough
+};
+
+struct FloodStats;
+
 /**
  * A mesh aware router that supports multiple interfaces.
  */
@@ -18,9 +30,17 @@ class Router : protected concurrency::OSThread
     /// forwarded to the phone.
     PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
 
+    /// Raw frames our radio has received, parsed into packets only once we get to them
+    RadioFrameRing fromRadioFrames;
+
+    RxDropStats rxDrops = {};
+
   protected:
     RadioInterface *iface = NULL;
 
+    /// How far away other nodes are, so our DMs don't flood further than they need to
+    HopLimitOptimizer hopLimits;
+
   public:
     /**
      * Constructor
@@ -73,6 +93,23 @@ class Router : protected concurrency::OSThread
      */
     void enqueueReceivedMessage(meshtastic_MeshPacket *p);
 
+    /**
+     * The slot for the radio to read its next received frame into, NULL if we haven't caught up yet.
+     * Once it has been filled in, the radio hands it to us with commitReceivedFrame()
+     */
+    RadioFrame *beginReceivedFrame()
+    {
+        RadioFrame *frame = fromRadioFrames.beginWrite();
+        if (!frame)
+            rxDrops.routerBusy++;
+        return frame;
+    }
+    void commitReceivedFrame()
+    {
+        fromRadioFrames.commitWrite();
+        setReceivedMessage();
+    }
+
     /**
      * Send a packet on a suitable interface.  This routine will
      * later free() the packet to pool.  This routine is not allowed to stall.
@@ -82,6 +119,23 @@ class Router : protected concurrency::OSThread
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p);
 
+    const RxDropStats &getRxDropStats() const { return rxDrops; }
+
+    /// What happened to the packets we could have rebroadcast, NULL if this router doesn't rebroadcast
+    virtual const FloodStats *getFloodStats() const { return NULL; }
+
+    /// The last byte of the neighbor that should relay p towards p->to, NO_NEXT_HOP to have it flooded
+    virtual uint8_t getNextHop(const meshtastic_MeshPacket *p) { return NO_NEXT_HOP; }
+
+    /// Called with the next_hop and relay_node bytes from the header of each packet from our radio, before handling it
+    virtual void sniffRelayHeader(const meshtastic_MeshPacket *p, uint8_t nextHop, uint8_t relayNode) {}
+
+    /// Learn that dest is hopsAway hops away through our neighbor relay, which we hear at snr
+    virtual void learnNextHop(NodeNum dest, NodeNum relay, uint8_t hopsAway, float snr) { hopLimits.noteHops(dest, hopsAway); }
+
+    /// Learn that n is hopsAway hops away, when we don't know through which neighbor (e.g. from a traceroute)
+    void learnHopsAway(NodeNum n, uint8_t hopsAway) { hopLimits.noteHops(n, hopsAway); }
+
   protected:
     friend class RoutingModule;
 
@@ -95,6 +149,15 @@ class Router : protected concurrency::OSThread
      */
     virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) { return false; }
 
+    /**
+     * Is this a copy of a packet we have already seen, that needs nothing more than its header to deal with?
+     *
+     * Called for every frame from our radio with only the header unpacked (encrypted.size is set, but not the bytes), so
+     * duplicates are dropped before we allocate, decrypt or decode anything for them.
+     * @return true if it has been dealt with and should be dropped, false to handle it as a whole packet
+     */
+    virtual bool shouldDropDuplicate(const meshtastic_MeshPacket *p) { return false; }
+
     /**
      * Every (non duplicate) packet this node receives will be passed through this method.  This allows subclasses to
      * update routing tables etc... based on what we overhear (even for messages not destined to our node)
@@ -118,6 +181,12 @@ class Router : protected concurrency::OSThread
      */
     void perhapsHandleReceived(meshtastic_MeshPacket *p);
 
+    /// Parse a frame from our radio into a packet, and handle it unless it's a duplicate
+    void handleReceivedFrame(const RadioFrame &frame);
+
+    /// Fill in the fields of p that come from the header of frame
+    static void unpackHeader(const RadioFrame &frame, meshtastic_MeshPacket *p);
+
     /**
      * Called from perhapsHandleReceived() - allows subclass message delivery behavior.
      * Handle any packet that is received by an interface on this node.
@@ -195,11 +195,11 @@ template <typename T> void SX128xInterface<T>::setStandby()
 /**
  * Add SNR data to received messages
  */
-template <typename T> void SX128xInterface<T>::addReceiveMetadata(meshtastic_MeshPacket *mp)
+template <typename T> void SX128xInterface<T>::addReceiveMetadata(RadioFrame *frame)
 {
     // LOG_DEBUG("PacketStatus %x\n", lora.getPacketStatus());
-    mp->rx_snr = lora.getSNR();
-    mp->rx_rssi = lround(lora.getRSSI());
+    frame->snr = lora.getSNR();
+    frame->rssi = lround(lora.getRSSI());
 }
 
 /** We override to turn on transmitter power as needed.
@@ -298,17 +298,22 @@ template <typename T> bool SX128xInterface<T>::isActivelyReceiving()
         uint32_t now = millis();
         if (!activeReceiveStart) {
             activeReceiveStart = now;
+            stats.lastPreambleMsec = now;
         } else if ((now - activeReceiveStart > 2 * preambleTimeMsec) && !(irq & RADIOLIB_SX128X_IRQ_HEADER_VALID)) {
             // The HEADER_VALID flag should be set by now if it was really a packet, so ignore PREAMBLE_DETECTED flag
             activeReceiveStart = 0;
             LOG_DEBUG("Ignore false preamble detection.\n");
+            stats.falsePreambles++;
             return false;
         } else if (now - activeReceiveStart > maxPacketTimeMsec) {
             // We should have gotten an RX_DONE IRQ by now if it was really a packet, so ignore HEADER_VALID flag
             activeReceiveStart = 0;
             LOG_DEBUG("Ignore false header detection.\n");
+            stats.falseHeaders++;
             return false;
         }
+        if ((irq & RADIOLIB_SX128X_IRQ_HEADER_VALID) && stats.lastHeaderMsec < activeReceiveStart)
+            stats.lastHeaderMsec = now;
     }
 
     return detected;
@@ -0,0 +1,46 @@
+#include "TxBackoff.h"
+
+uint8_t TxBackoff::apply(uint8_t cwSize, uint8_t cwMax) const
+{
+    uint8_t widened = cwSize + stats.stage;
+    return widened < cwMax ? widened : cwMax;
+}
+
+void TxBackoff::noteDeferred()
+{
+    stats.deferrals++;
+#if TX_BACKOFF_DEFERRALS_PER_STAGE > 0
+    if (++deferralsInRow >= TX_BACKOFF_DEFERRALS_PER_STAGE) {
+        deferralsInRow = 0;
+        grow();
+    }
+#endif
+}
+
+void TxBackoff::noteCollision()
+{
+    stats.collisions++;
+    // Take back the halving its transmission earned when it went out, then double
+    if (unconfirmedShrinks) {
+        unconfirmedShrinks--;
+        grow();
+    }
+    grow();
+}
+
+void TxBackoff::noteSuccess()
+{
+    stats.successes++;
+    deferralsInRow = 0;
+    if (stats.stage > 0) {
+        stats.stage--;
+        if (unconfirmedShrinks < TX_BACKOFF_MAX_STAGE)
+            unconfirmedShrinks++;
+    }
+}
+
+void TxBackoff::grow()
+{
+    if (stats.stage < TX_BACKOFF_MAX_STAGE)
+        stats.stage++;
+}
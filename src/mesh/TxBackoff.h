@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+/// How many doublings the adaptive back-off may add to the contention window
+#ifndef TX_BACKOFF_MAX_STAGE
+#define TX_BACKOFF_MAX_STAGE 4
+#endif
+
+/// Consecutive transmit attempts put off by a busy channel that count as one collision. 0 to only count them.
+/// Channel activity detection already keeps us off a busy channel, widening the window for it mostly wastes airtime
+#ifndef TX_BACKOFF_DEFERRALS_PER_STAGE
+#define TX_BACKOFF_DEFERRALS_PER_STAGE 0
+#endif
+
+/// The state of our back-off, for monitoring
+struct TxBackoffStats {
+    uint8_t stage;       // Doublings currently added to the contention window
+    uint32_t deferrals;  // Transmit attempts put off because the channel was busy
+    uint32_t collisions; // Packets of ours that needed a retransmission
+    uint32_t successes;  // Transmissions we got on the air
+};
+
+/**
+ * Binary exponential back-off on top of the contention window picked from the channel utilization.
+ *
+ * Channel utilization is averaged over seconds to a minute, so on its own it can't react to a burst of nodes all contending
+ * at once. Each collision (an unacknowledged packet) doubles the window, and each transmission we get on the air halves
+ * it again. We only learn of a collision once the packet wasn't acked, after its transmission already halved the window,
+ * so the collision takes that back first.
+ */
+class TxBackoff
+{
+  public:
+    /// Widen a contention window of 2^cwSize slots by our current stage, up to 2^cwMax slots
+    uint8_t apply(uint8_t cwSize, uint8_t cwMax) const;
+
+    /// We wanted to transmit, but the channel was busy
+    void noteDeferred();
+
+    /// A packet of ours wasn't acknowledged, so it most likely collided
+    void noteCollision();
+
+    /// We got a packet on the air
+    void noteSuccess();
+
+    const TxBackoffStats &getStats() const { return stats; }
+
+  private:
+    TxBackoffStats stats = {};
+    uint8_t deferralsInRow = 0;
+    uint8_t unconfirmedShrinks = 0; // Halvings a later collision may still take back
+
+    void grow();
+};
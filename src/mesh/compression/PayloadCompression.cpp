@@ -0,0 +1,168 @@
+#include "PayloadCompression.h"
+
+extern "C" {
+#include "unishox2.h"
+}
+
+// Ports that opted in besides text messages
+#ifndef PAYLOAD_COMPRESSION_MAX_PORTS
+#define PAYLOAD_COMPRESSION_MAX_PORTS 4
+#endif
+
+// unishox2 parameter sets. Its own presets are C compound literals, which C++ can't take, so ours are spelled out.
+// The horizontal codes pick how cheap letters, symbols, numbers, back references and unicode are. The standard set is
+// USX_PSET_DFLT, and the XML and JSON sets are USX_PSET_XML and USX_PSET_JSON. The chat sequences are six hand-picked
+// substrings of short English messages, not trained on a corpus
+static const unsigned char codesDefault[] = {0x00, 0x40, 0x80, 0xC0, 0xE0};
+static const unsigned char codeLensDefault[] = {2, 2, 2, 3, 3};
+
+static const char *standardSequences[] = {"\": \"", "\": ", "</", "=\"", "\":\"", "://"};
+static const char *chatSequences[] = {" the ", " you", "ing", " and ", " to ", "://"};
+static const char *xmlSequences[] = {"</", "=\"", "\">", "<?xml version=\"1.0\"", "xmlns:", "://"};
+static const char *jsonSequences[] = {"\": \"", "\": ", "\",", "}}}", "\":\"", "}}"};
+
+// ISO date and time, ISO date, US phone number, ISO time
+static const char *templates[] = {"tfff-of-tfTtf:rf:rf.fffZ", "tfff-of-tf", "(fff) fff-ffff", "tf:rf:rf", 0};
+
+struct Dictionary {
+    const char *name;
+    const unsigned char *codes;
+    const unsigned char *codeLens;
+    const char **sequences;
+};
+
+static const Dictionary dictionaries[NUM_PAYLOAD_DICTIONARIES] = {
+    {"standard", codesDefault, codeLensDefault, standardSequences},
+    {"chat", codesDefault, codeLensDefault, chatSequences},
+    {"xml", codesDefault, codeLensDefault, xmlSequences},
+    {"json", codesDefault, codeLensDefault, jsonSequences},
+};
+
+struct OptedInPort {
+    meshtastic_PortNum port;
+    PayloadDictionary dictionary;
+};
+
+// Ports a build opted in with PAYLOAD_COMPRESSION_XML_PORT or PAYLOAD_COMPRESSION_JSON_PORT, ahead of the modules'
+static OptedInPort optedIn[PAYLOAD_COMPRESSION_MAX_PORTS] = {
+#ifdef PAYLOAD_COMPRESSION_XML_PORT
+    {(meshtastic_PortNum)PAYLOAD_COMPRESSION_XML_PORT, DICTIONARY_XML},
+#endif
+#ifdef PAYLOAD_COMPRESSION_JSON_PORT
+    {(meshtastic_PortNum)PAYLOAD_COMPRESSION_JSON_PORT, DICTIONARY_JSON},
+#endif
+};
+static size_t numOptedIn =
+#ifdef PAYLOAD_COMPRESSION_XML_PORT
+    1 +
+#endif
+#ifdef PAYLOAD_COMPRESSION_JSON_PORT
+    1 +
+#endif
+    0;
+
+static const OptedInPort *findPort(meshtastic_PortNum port)
+{
+    for (size_t i = 0; i < numOptedIn; i++)
+        if (optedIn[i].port == port)
+            return &optedIn[i];
+    return NULL;
+}
+
+bool PayloadCompression::optIn(meshtastic_PortNum port, PayloadDictionary dictionary)
+{
+    if (findPort(port))
+        return true;
+    if (numOptedIn >= PAYLOAD_COMPRESSION_MAX_PORTS) {
+        LOG_WARN("No room to compress port %d, raise PAYLOAD_COMPRESSION_MAX_PORTS\n", port);
+        return false;
+    }
+    optedIn[numOptedIn++] = {port, dictionary};
+    return true;
+}
+
+size_t PayloadCompression::compressBytes(PayloadDictionary dictionary, const uint8_t *bytes, size_t size, uint8_t *out,
+                                         size_t outSize)
+{
+    const Dictionary &d = dictionaries[dictionary];
+    int len = unishox2_compress((const char *)bytes, size, (char *)out, outSize, d.codes, d.codeLens, d.sequences, templates);
+    return (len > 0 && (size_t)len <= outSize) ? len : 0;
+}
+
+size_t PayloadCompression::decompressBytes(PayloadDictionary dictionary, const uint8_t *bytes, size_t size, uint8_t *out,
+                                           size_t outSize)
+{
+    const Dictionary &d = dictionaries[dictionary];
+    int len = unishox2_decompress((const char *)bytes, size, (char *)out, outSize, d.codes, d.codeLens, d.sequences, templates);
+    return (len > 0 && (size_t)len <= outSize) ? len : 0;
+}
+
+bool PayloadCompression::compress(meshtastic_Data &d)
+{
+    PayloadDictionary dictionary;
+    size_t header = 0; // Bytes in front of the compressed payload
+    if (d.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
+        dictionary = DICTIONARY_STANDARD;
+    } else if (const OptedInPort *opted = findPort(d.portnum)) {
+        dictionary = opted->dictionary;
+        header = 1;
+    } else {
+        return false;
+    }
+    if (d.payload.size < PAYLOAD_COMPRESSION_MIN_SIZE)
+        return false;
+
+    // Only worth it if it saves at least a byte, so don't let it grow any bigger than that
+    uint8_t compressed[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    size_t len = compressBytes(dictionary, d.payload.bytes, d.payload.size, compressed + header, d.payload.size - header - 1);
+    if (!len)
+        return false;
+
+    // unishox2 is made for text, make sure the payload comes back exactly as it was before we send it like this
+    uint8_t roundTrip[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    if (decompressBytes(dictionary, compressed + header, len, roundTrip, sizeof(roundTrip)) != d.payload.size ||
+        memcmp(roundTrip, d.payload.bytes, d.payload.size) != 0)
+        return false;
+
+    LOG_DEBUG("Compressed port %d payload from %d to %d bytes\n", d.portnum, d.payload.size, len + header);
+    if (header)
+        compressed[0] = PAYLOAD_COMPRESSED_MARKER;
+    else
+        d.portnum = meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP;
+    d.payload.size = len + header;
+    memcpy(d.payload.bytes, compressed, d.payload.size);
+    return true;
+}
+
+bool PayloadCompression::decompress(meshtastic_Data &d)
+{
+    PayloadDictionary dictionary;
+    size_t header = 0;
+    if (d.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP) {
+        dictionary = DICTIONARY_STANDARD;
+    } else if (const OptedInPort *opted = findPort(d.portnum)) {
+        if (d.payload.size == 0 || d.payload.bytes[0] != PAYLOAD_COMPRESSED_MARKER)
+            return true; // Sent uncompressed
+        dictionary = opted->dictionary;
+        header = 1;
+    } else {
+        return true;
+    }
+
+    uint8_t decompressed[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    size_t len = decompressBytes(dictionary, d.payload.bytes + header, d.payload.size - header, decompressed,
+                                 sizeof(decompressed));
+    if (!len)
+        return false;
+
+    if (!header)
+        d.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    d.payload.size = len;
+    memcpy(d.payload.bytes, decompressed, len);
+    return true;
+}
+
+const char *PayloadCompression::dictionaryName(PayloadDictionary dictionary)
+{
+    return dictionary < NUM_PAYLOAD_DICTIONARIES ? dictionaries[dictionary].name : "unknown";
+}
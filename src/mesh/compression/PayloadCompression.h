@@ -0,0 +1,59 @@
+#pragma once
+#include "configuration.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
+
+// Build with PAYLOAD_COMPRESSION=1 to compress the payloads of ports that opted in. Every node decompresses them, so
+// a mesh can be upgraded first and have this turned on later
+#ifndef PAYLOAD_COMPRESSION
+#define PAYLOAD_COMPRESSION 0
+#endif
+
+// Set either to a port number whose payloads are CoT XML or JSON text, e.g. a PRIVATE_APP sensor feed, to compress that
+// port with the XML or JSON dictionary. Both are off by default: ATAK_PLUGIN carries TAKPacket protobufs, ATAK_FORWARDER
+// carries libcotshrink output, and no standard port carries JSON, so none of them is text the marker byte can front
+// #define PAYLOAD_COMPRESSION_XML_PORT meshtastic_PortNum_PRIVATE_APP
+// #define PAYLOAD_COMPRESSION_JSON_PORT meshtastic_PortNum_PRIVATE_APP
+
+// Payloads shorter than this are left alone, they rarely get smaller
+#ifndef PAYLOAD_COMPRESSION_MIN_SIZE
+#define PAYLOAD_COMPRESSION_MIN_SIZE 8
+#endif
+
+/**
+ * unishox2 codes and frequent sequences to compress with. DICTIONARY_STANDARD is unishox2's default preset, the one
+ * unishox2_compress_simple() uses, so TEXT_MESSAGE_COMPRESSED_APP stays readable by every other sender and receiver.
+ * DICTIONARY_XML and DICTIONARY_JSON are unishox2's USX_PSET_XML and USX_PSET_JSON presets.
+ */
+enum PayloadDictionary { DICTIONARY_STANDARD, DICTIONARY_CHAT, DICTIONARY_XML, DICTIONARY_JSON, NUM_PAYLOAD_DICTIONARIES };
+
+/**
+ * Optional compression of decoded payloads, applied by perhapsEncode and undone by perhapsDecode.
+ *
+ * Text messages are on by default and travel as TEXT_MESSAGE_COMPRESSED_APP, with the standard dictionary. Other ports
+ * have no compressed twin, so a module has to opt in with the port it uses, and its compressed payloads start with
+ * PAYLOAD_COMPRESSED_MARKER. That byte can't start UTF-8 text, so only ports that carry text may opt in.
+ * A payload is only sent compressed if that saves at least a byte.
+ */
+class PayloadCompression
+{
+  public:
+    static const uint8_t PAYLOAD_COMPRESSED_MARKER = 0xff;
+
+    /// Compress the payloads of port with dictionary from now on, and decompress them on the way in
+    static bool optIn(meshtastic_PortNum port, PayloadDictionary dictionary);
+
+    /// Compress d in place if its port opted in and it gets smaller. Returns true if it did
+    static bool compress(meshtastic_Data &d);
+
+    /// Undo compress() in place. Returns false, and leaves d as it was, if d was compressed but is corrupt
+    static bool decompress(meshtastic_Data &d);
+
+    /// Compress bytes with dictionary into out. Returns the compressed length, or 0 if it doesn't fit in outSize
+    static size_t compressBytes(PayloadDictionary dictionary, const uint8_t *bytes, size_t size, uint8_t *out, size_t outSize);
+
+    /// Decompress bytes with dictionary into out. Returns the original length, or 0 if it is corrupt or doesn't fit
+    static size_t decompressBytes(PayloadDictionary dictionary, const uint8_t *bytes, size_t size, uint8_t *out,
+                                  size_t outSize);
+
+    static const char *dictionaryName(PayloadDictionary dictionary);
+};
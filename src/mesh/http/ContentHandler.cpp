@@ -1,6 +1,7 @@
 #if !MESHTASTIC_EXCLUDE_WEBSERVER
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "RTC.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
 #include "main.h"
@@ -9,6 +10,7 @@
 #if !MESHTASTIC_EXCLUDE_WIFI
 #include "mesh/wifi/WiFiAPClient.h"
 #endif
+#include "modules/Telemetry/TelemetryHistory.h"
 #include "mqtt/JSON.h"
 #include "power.h"
 #include "sleep.h"
@@ -92,6 +94,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     ResourceNode *nodeJsonScanNetworks = new ResourceNode("/json/scanNetworks", "GET", &handleScanNetworks);
     ResourceNode *nodeJsonBlinkLED = new ResourceNode("/json/blink", "POST", &handleBlinkLED);
     ResourceNode *nodeJsonReport = new ResourceNode("/json/report", "GET", &handleReport);
+    ResourceNode *nodeJsonTelemetry = new ResourceNode("/json/telemetry", "GET", &handleTelemetryHistory);
     ResourceNode *nodeJsonFsBrowseStatic = new ResourceNode("/json/fs/browse/static", "GET", &handleFsBrowseStatic);
     ResourceNode *nodeJsonDelete = new ResourceNode("/json/fs/delete/static", "DELETE", &handleFsDeleteStatic);
 
@@ -110,6 +113,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     secureServer->registerNode(nodeJsonFsBrowseStatic);
     secureServer->registerNode(nodeJsonDelete);
     secureServer->registerNode(nodeJsonReport);
+    secureServer->registerNode(nodeJsonTelemetry);
     //    secureServer->registerNode(nodeUpdateFs);
     //    secureServer->registerNode(nodeDeleteFs);
     secureServer->registerNode(nodeAdmin);
@@ -131,6 +135,7 @@ void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
     insecureServer->registerNode(nodeJsonFsBrowseStatic);
     insecureServer->registerNode(nodeJsonDelete);
     insecureServer->registerNode(nodeJsonReport);
+    insecureServer->registerNode(nodeJsonTelemetry);
     //    insecureServer->registerNode(nodeUpdateFs);
     //    insecureServer->registerNode(nodeDeleteFs);
     insecureServer->registerNode(nodeAdmin);
@@ -652,6 +657,23 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjRadio["frequency"] = new JSONValue(RadioLibInterface::instance->getFreq());
     jsonObjRadio["lora_channel"] = new JSONValue((int)RadioLibInterface::instance->getChannelNum() + 1);
 
+    // data->nearby, only when asked for with ?nearby=<count> and we know where we are
+    JSONArray nearbyValues;
+    std::string nearby;
+    meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    bool wantNearby =
+        params->getQueryParameter("nearby", nearby) && atoi(nearby.c_str()) > 0 && ourNode && hasValidPosition(ourNode);
+    if (wantNearby) {
+        std::vector<NodeDistance> nearest;
+        nodeDB->getNearestNodes(ourNode->position.latitude_i, ourNode->position.longitude_i, atoi(nearby.c_str()), nearest);
+        for (const NodeDistance &n : nearest) {
+            JSONObject jsonObjNode;
+            jsonObjNode["num"] = new JSONValue((uint)n.num);
+            jsonObjNode["distance"] = new JSONValue((int)n.distance);
+            nearbyValues.push_back(new JSONValue(jsonObjNode));
+        }
+    }
+
     // collect data to inner data object
     JSONObject jsonObjInner;
     jsonObjInner["airtime"] = new JSONValue(jsonObjAirtime);
@@ -660,6 +682,8 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjInner["power"] = new JSONValue(jsonObjPower);
     jsonObjInner["device"] = new JSONValue(jsonObjDevice);
     jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    if (wantNearby)
+        jsonObjInner["nearby"] = new JSONValue(nearbyValues);
 
     // create json output structure
     JSONObject jsonObjOuter;
@@ -671,6 +695,40 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     delete value;
 }
 
+/*
+    Our recorded telemetry in one batch. Optional parameters:
+        resolution - raw, minute, quarter or hour (the default)
+        since - unix time of the oldest reading wanted, defaults to a day ago
+    Each metric is a list of [time, min, max, avg, count] buckets, oldest first.
+*/
+void handleTelemetryHistory(HTTPRequest *req, HTTPResponse *res)
+{
+    ResourceParameters *params = req->getParams();
+    std::string resolutionParam;
+    std::string sinceParam;
+
+    res->setHeader("Content-Type", "application/json");
+    res->setHeader("Access-Control-Allow-Origin", "*");
+    res->setHeader("Access-Control-Allow-Methods", "GET");
+
+    TelemetryResolution resolution = RESOLUTION_HOUR;
+    if (params->getQueryParameter("resolution", resolutionParam))
+        resolution = TelemetryHistory::parseResolution(resolutionParam.c_str());
+
+    uint32_t now = getTime();
+    uint32_t since = now > SEC_PER_DAY ? now - SEC_PER_DAY : 0;
+    if (params->getQueryParameter("since", sinceParam))
+        since = strtoul(sinceParam.c_str(), nullptr, 10);
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = telemetryHistory.toJSON(resolution, since);
+    jsonObjOuter["status"] = new JSONValue("ok");
+
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    res->print(value->Stringify().c_str());
+    delete value;
+}
+
 /*
     This supports the Apple Captive Network Assistant (CNA) Portal
 */
@@ -37,14 +37,19 @@ mail:   marchammermann@googlemail.com
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
+#include "FloodingRouter.h"
 #include "NodeDB.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
+#include "RTC.h"
 #include "RadioLibInterface.h"
+#include "Router.h"
 #include "airtime.h"
 #include "graphics/Screen.h"
 #include "main.h"
 #include "mesh/wifi/WiFiAPClient.h"
+#include "modules/Telemetry/TelemetryHistory.h"
+#include "mqtt/JSON.h"
 #include "sleep.h"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
@@ -67,6 +72,8 @@ mail:   marchammermann@googlemail.com
 
 struct _file_config configWeb;
 
+extern RadioInterface *rIf;
+
 // We need to specify some content-type mapping, so the resources get delivered with the
 // right content type and are displayed correctly in the browser
 char contentTypes[][2][32] = {{".txt", "text/plain"},      {".html", "text/html"},
@@ -296,6 +303,194 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
     return U_CALLBACK_COMPLETE;
 }
 
+/*
+ * Radio and receive statistics as JSON, for tuning hop limits and modem presets
+ * Trigger : GET /json/radio
+ */
+int handleJsonRadioStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    JSONObject jsonObjInner;
+    jsonObjInner["now_msec"] = new JSONValue((uint)millis());
+
+    // data->radio, only if we have a real (RadioLib) radio
+    if (RadioLibInterface::instance) {
+        const RadioStats &r = RadioLibInterface::instance->getStats();
+        JSONObject jsonObjRadio;
+        jsonObjRadio["rx_good"] = new JSONValue((uint)r.rxGood);
+        jsonObjRadio["rx_crc_errors"] = new JSONValue((uint)r.rxCrcErrors);
+        jsonObjRadio["rx_other_errors"] = new JSONValue((uint)r.rxOtherErrors);
+        jsonObjRadio["rx_too_short"] = new JSONValue((uint)r.rxTooShort);
+        jsonObjRadio["rx_no_sender"] = new JSONValue((uint)r.rxNoSender);
+        jsonObjRadio["false_preambles"] = new JSONValue((uint)r.falsePreambles);
+        jsonObjRadio["false_headers"] = new JSONValue((uint)r.falseHeaders);
+        jsonObjRadio["tx_good"] = new JSONValue((uint)r.txGood);
+        jsonObjRadio["tx_failed"] = new JSONValue((uint)r.txFailed);
+        jsonObjRadio["busy_rx_deferrals"] = new JSONValue((uint)r.busyRxDeferrals);
+        jsonObjRadio["busy_tx_deferrals"] = new JSONValue((uint)r.busyTxDeferrals);
+        jsonObjRadio["channel_active_deferrals"] = new JSONValue((uint)r.channelActiveDeferrals);
+        jsonObjRadio["cad_scans"] = new JSONValue((uint)r.cadScans);
+        jsonObjRadio["lbt_retries"] = new JSONValue((uint)r.lbtRetries);
+        jsonObjRadio["lbt_redraws"] = new JSONValue((uint)r.lbtRedraws);
+        jsonObjRadio["rx_airtime_msec"] = new JSONValue((uint)r.rxAirtimeMsec);
+        jsonObjRadio["tx_airtime_msec"] = new JSONValue((uint)r.txAirtimeMsec);
+        jsonObjRadio["tx_queue_wait_msec"] = new JSONValue((uint)r.txQueueWaitMsec);
+        jsonObjRadio["tx_queue_wait_max_msec"] = new JSONValue((uint)r.txQueueWaitMaxMsec);
+        jsonObjRadio["lbt_wait_msec"] = new JSONValue((uint)r.lbtWaitMsec);
+        jsonObjRadio["lbt_wait_max_msec"] = new JSONValue((uint)r.lbtWaitMaxMsec);
+        jsonObjRadio["last_preamble_msec"] = new JSONValue((uint)r.lastPreambleMsec);
+        jsonObjRadio["last_header_msec"] = new JSONValue((uint)r.lastHeaderMsec);
+        jsonObjRadio["last_rx_done_msec"] = new JSONValue((uint)r.lastRxDoneMsec);
+        jsonObjRadio["last_tx_done_msec"] = new JSONValue((uint)r.lastTxDoneMsec);
+        jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    }
+
+    // data->backoff
+    if (rIf) {
+        const TxBackoffStats &b = rIf->getBackoffStats();
+        JSONObject jsonObjBackoff;
+        jsonObjBackoff["stage"] = new JSONValue((uint)b.stage);
+        jsonObjBackoff["deferrals"] = new JSONValue((uint)b.deferrals);
+        jsonObjBackoff["collisions"] = new JSONValue((uint)b.collisions);
+        jsonObjBackoff["successes"] = new JSONValue((uint)b.successes);
+        jsonObjInner["backoff"] = new JSONValue(jsonObjBackoff);
+    }
+
+    // data->rx_drops
+    if (router) {
+        const RxDropStats &d = router->getRxDropStats();
+        JSONObject jsonObjDrops;
+        jsonObjDrops["router_busy"] = new JSONValue((uint)d.routerBusy);
+        jsonObjDrops["ignored"] = new JSONValue((uint)d.ignored);
+        jsonObjDrops["duplicate"] = new JSONValue((uint)d.duplicate);
+        jsonObjDrops["filtered"] = new JSONValue((uint)d.filtered);
+        jsonObjInner["rx_drops"] = new JSONValue(jsonObjDrops);
+    }
+
+    // data->flooding
+    if (router && router->getFloodStats()) {
+        const FloodStats &f = *router->getFloodStats();
+        JSONObject jsonObjFlooding;
+        jsonObjFlooding["rebroadcasts"] = new JSONValue((uint)f.rebroadcasts);
+        jsonObjFlooding["duplicates"] = new JSONValue((uint)f.duplicates);
+        jsonObjFlooding["cancelled_duplicate"] = new JSONValue((uint)f.cancelledDuplicate);
+        jsonObjFlooding["suppressed_count"] = new JSONValue((uint)f.suppressedCount);
+        jsonObjFlooding["suppressed_coverage"] = new JSONValue((uint)f.suppressedCoverage);
+        jsonObjInner["flooding"] = new JSONValue(jsonObjFlooding);
+    }
+
+    // data->airtime
+    JSONObject jsonObjAirtime;
+    jsonObjAirtime["channel_utilization"] = new JSONValue(airTime->channelUtilizationPercent());
+    jsonObjAirtime["utilization_tx"] = new JSONValue(airTime->utilizationTXPercent());
+    jsonObjInner["airtime"] = new JSONValue(jsonObjAirtime);
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjInner);
+    jsonObjOuter["status"] = new JSONValue("ok");
+
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Our recorded telemetry in one batch, same as /json/telemetry on the ESP32 webserver. Optional parameters:
+ *     resolution - raw, minute, quarter or hour (the default)
+ *     since - unix time of the oldest reading wanted, defaults to a day ago
+ * Trigger : GET /json/telemetry
+ */
+int handleJsonTelemetryHistory(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    TelemetryResolution resolution = TelemetryHistory::parseResolution(u_map_get(req->map_url, "resolution"));
+
+    uint32_t now = getTime();
+    uint32_t since = now > SEC_PER_DAY ? now - SEC_PER_DAY : 0;
+    const char *sinceParam = u_map_get(req->map_url, "since");
+    if (sinceParam)
+        since = strtoul(sinceParam, nullptr, 10);
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = telemetryHistory.toJSON(resolution, since);
+    jsonObjOuter["status"] = new JSONValue("ok");
+
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Nodes with a known position near a point, nearest first, like ?nearby= on the ESP32 /json/report. Parameters:
+ *     count - the nearest count nodes, or
+ *     radius - every node within radius meters
+ *     latitude_i, longitude_i - the point in 1e-7 degrees, defaults to our own position
+ * Trigger : GET /json/nearby
+ */
+int handleJsonNearby(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    const char *countParam = u_map_get(req->map_url, "count");
+    const char *radiusParam = u_map_get(req->map_url, "radius");
+    const char *latParam = u_map_get(req->map_url, "latitude_i");
+    const char *lonParam = u_map_get(req->map_url, "longitude_i");
+
+    bool havePoint = false;
+    int32_t latitude = 0, longitude = 0;
+    if (latParam && lonParam) {
+        latitude = atoi(latParam);
+        longitude = atoi(lonParam);
+        havePoint = true;
+    } else {
+        meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
+        if (ourNode && hasValidPosition(ourNode)) {
+            latitude = ourNode->position.latitude_i;
+            longitude = ourNode->position.longitude_i;
+            havePoint = true;
+        }
+    }
+
+    std::vector<NodeDistance> nearest;
+    if (havePoint && countParam && atoi(countParam) > 0)
+        nodeDB->getNearestNodes(latitude, longitude, atoi(countParam), nearest);
+    else if (havePoint && radiusParam && atof(radiusParam) > 0)
+        nodeDB->getNodesWithin(latitude, longitude, atof(radiusParam), nearest);
+
+    JSONArray nearbyValues;
+    for (const NodeDistance &n : nearest) {
+        JSONObject jsonObjNode;
+        jsonObjNode["num"] = new JSONValue((uint)n.num);
+        jsonObjNode["distance"] = new JSONValue((int)n.distance);
+        nearbyValues.push_back(new JSONValue(jsonObjNode));
+    }
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(nearbyValues);
+    jsonObjOuter["status"] = new JSONValue(havePoint ? "ok" : "no position");
+
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -494,6 +689,9 @@ PiWebServerThread::PiWebServerThread()
         instanceWeb.max_post_body_size = 1024;
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, configWeb.rootPath);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/radio", 1, &handleJsonRadioStats, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/telemetry", 1, &handleJsonTelemetryHistory, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/nearby", 1, &handleJsonNearby, NULL);
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
@@ -1,5 +1,6 @@
 #pragma once
 #include "SinglePortModule.h"
+#include "mesh/compression/PayloadCompression.h"
 
 class DetectionSensorModule : public SinglePortModule, private concurrency::OSThread
 {
@@ -7,6 +8,8 @@ class DetectionSensorModule : public SinglePortModule, private concurrency::OSTh
     DetectionSensorModule()
         : SinglePortModule("detection", meshtastic_PortNum_DETECTION_SENSOR_APP), OSThread("DetectionSensorModule")
     {
+        // Our messages are short English text
+        PayloadCompression::optIn(meshtastic_PortNum_DETECTION_SENSOR_APP, DICTIONARY_CHAT);
     }
 
   protected:
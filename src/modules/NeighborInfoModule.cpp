@@ -3,6 +3,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "RTC.h"
+#include "Router.h"
 
 NeighborInfoModule *neighborInfoModule;
 
@@ -163,6 +164,10 @@ void NeighborInfoModule::updateNeighbors(const meshtastic_MeshPacket &mp, const
     // an edge. So we assume that if it's zero, then this packet is from our node.
     if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.from) {
         getOrCreateNeighbor(mp.from, np->last_sent_by_id, np->node_broadcast_interval_secs, mp.rx_snr);
+
+        // last_sent_by_id is the neighbor that relayed this to us, so it is a route to the sender
+        if (router && np->last_sent_by_id && mp.hop_start != 0 && mp.hop_limit <= mp.hop_start)
+            router->learnNextHop(mp.from, np->last_sent_by_id, mp.hop_start - mp.hop_limit, mp.rx_snr);
     }
 }
 
@@ -370,8 +370,8 @@ struct SmartPosition PositionModule::getDistanceTraveledSinceLastSend(meshtastic
         Default::getConfiguredOrDefault(config.position.broadcast_smart_minimum_distance, 100);
 
     // Determine the distance in meters between two points on the globe
-    float distanceTraveledSinceLastSend = GeoCoord::latLongToMeter(
-        lastGpsLatitude * 1e-7, lastGpsLongitude * 1e-7, currentPosition.latitude_i * 1e-7, currentPosition.longitude_i * 1e-7);
+    float distanceTraveledSinceLastSend =
+        GeoCoord::latLongToMeterFast(lastGpsLatitude, lastGpsLongitude, currentPosition.latitude_i, currentPosition.longitude_i);
 
 #ifdef GPS_EXTRAVERBOSE
     LOG_DEBUG("--------LAST POSITION------------------------------------\n");
@@ -18,6 +18,7 @@
 #include "airtime.h"
 #include "configuration.h"
 #include "gps/GeoCoord.h"
+#include "sleep.h"
 #include <Arduino.h>
 
 RangeTestModule *rangeTestModule;
@@ -25,6 +26,12 @@ RangeTestModuleRadio *rangeTestModuleRadio;
 
 RangeTestModule::RangeTestModule() : concurrency::OSThread("RangeTestModule") {}
 
+RangeTestModuleRadio::RangeTestModuleRadio() : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP)
+{
+    loopbackOk = true; // Allow locally generated messages to loop back to the client
+    notifyDeepSleepObserver.observe(&notifyDeepSleep);
+}
+
 uint32_t packetSequence = 0;
 
 #define SEC_PER_DAY 86400
@@ -33,7 +40,7 @@ uint32_t packetSequence = 0;
 
 int32_t RangeTestModule::runOnce()
 {
-#if defined(ARCH_ESP32) || defined(ARCH_NRF52)
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_PORTDUINO)
 
     /*
         Uncomment the preferences below if you want to use the module
@@ -62,10 +69,11 @@ int32_t RangeTestModule::runOnce()
                 return (5000);      // Sending first message 5 seconds after initialization.
             } else {
                 LOG_INFO("Initializing Range Test Module -- Receiver\n");
-                return disable();
-                // This thread does not need to run as a receiver
+                // As a receiver this thread only writes out the log
+                return moduleConfig.range_test.save ? RANGETEST_LOG_FLUSH_MSEC : disable();
             }
         } else {
+            rangeTestModuleRadio->flushFile(false);
 
             if (moduleConfig.range_test.sender) {
                 // If sender
@@ -85,10 +93,13 @@ int32_t RangeTestModule::runOnce()
                 // If we have been running for more than 8 hours, turn module back off
                 if (millis() - started > 28800000) {
                     LOG_INFO("Range Test Module - Disabling after 8 hours\n");
+                    rangeTestModuleRadio->flushFile();
                     return disable();
                 } else {
                     return (senderHeartbeat);
                 }
+            } else if (moduleConfig.range_test.save) {
+                return RANGETEST_LOG_FLUSH_MSEC;
             } else {
                 return disable();
                 // This thread does not need to run as a receiver
@@ -132,7 +143,7 @@ void RangeTestModuleRadio::sendPayload(NodeNum dest, bool wantReplies)
 
 ProcessMessage RangeTestModuleRadio::handleReceived(const meshtastic_MeshPacket &mp)
 {
-#if defined(ARCH_ESP32) || defined(ARCH_NRF52)
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_PORTDUINO)
 
     if (moduleConfig.range_test.enabled) {
 
@@ -185,73 +196,14 @@ ProcessMessage RangeTestModuleRadio::handleReceived(const meshtastic_MeshPacket
 
 bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
 {
-#ifdef ARCH_ESP32
+#ifdef FSCom
     auto &p = mp.decoded;
 
     meshtastic_NodeInfoLite *n = nodeDB->getMeshNode(getFrom(&mp));
-    /*
-        LOG_DEBUG("-----------------------------------------\n");
-        LOG_DEBUG("p.payload.bytes  \"%s\"\n", p.payload.bytes);
-        LOG_DEBUG("p.payload.size   %d\n", p.payload.size);
-        LOG_DEBUG("---- Received Packet:\n");
-        LOG_DEBUG("mp.from          %d\n", mp.from);
-        LOG_DEBUG("mp.rx_snr        %f\n", mp.rx_snr);
-        LOG_DEBUG("mp.hop_limit     %d\n", mp.hop_limit);
-        // LOG_DEBUG("mp.decoded.position.latitude_i     %d\n", mp.decoded.position.latitude_i);  // Deprecated
-        // LOG_DEBUG("mp.decoded.position.longitude_i    %d\n", mp.decoded.position.longitude_i); // Deprecated
-        LOG_DEBUG("---- Node Information of Received Packet (mp.from):\n");
-        LOG_DEBUG("n->user.long_name         %s\n", n->user.long_name);
-        LOG_DEBUG("n->user.short_name        %s\n", n->user.short_name);
-        LOG_DEBUG("n->has_position           %d\n", n->has_position);
-        LOG_DEBUG("n->position.latitude_i    %d\n", n->position.latitude_i);
-        LOG_DEBUG("n->position.longitude_i   %d\n", n->position.longitude_i);
-        LOG_DEBUG("---- Current device location information:\n");
-        LOG_DEBUG("gpsStatus->getLatitude()     %d\n", gpsStatus->getLatitude());
-        LOG_DEBUG("gpsStatus->getLongitude()    %d\n", gpsStatus->getLongitude());
-        LOG_DEBUG("gpsStatus->getHasLock()      %d\n", gpsStatus->getHasLock());
-        LOG_DEBUG("gpsStatus->getDOP()          %d\n", gpsStatus->getDOP());
-        LOG_DEBUG("-----------------------------------------\n");
-    */
-    if (!FSBegin()) {
-        LOG_DEBUG("An Error has occurred while mounting the filesystem\n");
-        return 0;
-    }
-
-    if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
-        LOG_DEBUG("Filesystem doesn't have enough free space. Aborting write.\n");
-        return 0;
-    }
-
-    FSCom.mkdir("/static");
-
-    // If the file doesn't exist, write the header.
-    if (!FSCom.exists("/static/rangetest.csv")) {
-        //--------- Write to file
-        File fileToWrite = FSCom.open("/static/rangetest.csv", FILE_WRITE);
 
-        if (!fileToWrite) {
-            LOG_ERROR("There was an error opening the file for writing\n");
-            return 0;
-        }
-
-        // Print the CSV header
-        if (fileToWrite.println(
-                "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload")) {
-            LOG_INFO("File was written\n");
-        } else {
-            LOG_ERROR("File write failed\n");
-        }
-        fileToWrite.flush();
-        fileToWrite.close();
-    }
-
-    //--------- Append content to file
-    File fileToAppend = FSCom.open("/static/rangetest.csv", FILE_APPEND);
-
-    if (!fileToAppend) {
-        LOG_ERROR("There was an error opening the file for appending\n");
-        return 0;
-    }
+    // Format the whole row up front, it is written out later together with its neighbours
+    char row[160 + sizeof(n->user.long_name) + meshtastic_Constants_DATA_PAYLOAD_LEN];
+    size_t len = 0;
 
     struct timeval tv;
     if (!gettimeofday(&tv, NULL)) {
@@ -263,36 +215,95 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
         int min = (hms % SEC_PER_HOUR) / SEC_PER_MIN;
         int sec = (hms % SEC_PER_HOUR) % SEC_PER_MIN; // or hms % SEC_PER_MIN
 
-        fileToAppend.printf("%02d:%02d:%02d,", hour, min, sec); // Time
+        len += snprintf(row + len, sizeof(row) - len, "%02d:%02d:%02d,", hour, min, sec); // Time
     } else {
-        fileToAppend.printf("??:??:??,"); // Time
+        len += snprintf(row + len, sizeof(row) - len, "??:??:??,"); // Time
     }
 
-    fileToAppend.printf("%d,", getFrom(&mp));                     // From
-    fileToAppend.printf("%s,", n->user.long_name);                // Long Name
-    fileToAppend.printf("%f,", n->position.latitude_i * 1e-7);    // Sender Lat
-    fileToAppend.printf("%f,", n->position.longitude_i * 1e-7);   // Sender Long
-    fileToAppend.printf("%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
-    fileToAppend.printf("%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
-    fileToAppend.printf("%d,", gpsStatus->getAltitude());         // RX Altitude
+    float distance = 0;
+    if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
+        distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
+                                            gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
+    }
 
-    fileToAppend.printf("%f,", mp.rx_snr); // RX SNR
+    // TODO: If quotes are found in the payload, it has to be escaped.
+    snprintf(row + len, sizeof(row) - len, "%d,%s,%f,%f,%f,%f,%d,%f,%f,%d,\"%.*s\"\n",
+             getFrom(&mp),                        // From
+             n->user.long_name,                   // Long Name
+             n->position.latitude_i * 1e-7,       // Sender Lat
+             n->position.longitude_i * 1e-7,      // Sender Long
+             gpsStatus->getLatitude() * 1e-7,     // RX Lat
+             gpsStatus->getLongitude() * 1e-7,    // RX Long
+             gpsStatus->getAltitude(),            // RX Altitude
+             mp.rx_snr,                           // RX SNR
+             distance,                            // Distance in meters
+             mp.hop_limit,                        // Packet Hop Limit
+             (int)p.payload.size, p.payload.bytes // Payload
+    );
+
+    if (logBuffer.empty())
+        logBufferSince = millis();
+    logBuffer += row;
+
+    if (logBuffer.size() >= RANGETEST_LOG_FLUSH_BYTES)
+        flushFile();
+#endif
 
-    if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
-        float distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
-                                                  gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
-        fileToAppend.printf("%f,", distance); // Distance in meters
-    } else {
-        fileToAppend.printf("0,");
+    return 1;
+}
+
+#if defined(ARCH_NRF52)
+#define RANGETEST_FILE_APPEND FILE_O_WRITE // Adafruit LittleFS opens for writing at the end of the file
+#else
+#define RANGETEST_FILE_APPEND "a"
+#endif
+
+void RangeTestModuleRadio::flushFile(bool force)
+{
+#ifdef FSCom
+    if (logBuffer.empty() || (!force && millis() - logBufferSince < RANGETEST_LOG_FLUSH_MSEC))
+        return;
+
+    if (fsFreeBytes() < RANGETEST_LOG_MIN_FREE_BYTES) {
+        LOG_DEBUG("Filesystem doesn't have enough free space. Dropping %u bytes of range test log.\n", logBuffer.size());
+        logBuffer.clear();
+        return;
     }
 
-    fileToAppend.printf("%d,", mp.hop_limit); // Packet Hop Limit
+    FSCom.mkdir("/static");
 
-    // TODO: If quotes are found in the payload, it has to be escaped.
-    fileToAppend.printf("\"%s\"\n", p.payload.bytes);
+    // Start over in a new file once this one is big enough, keeping the previous one
+    bool newFile = !FSCom.exists("/static/rangetest.csv");
+    if (!newFile) {
+        File existing = FSCom.open("/static/rangetest.csv", FILE_O_READ);
+        size_t size = existing ? existing.size() : 0;
+        if (existing)
+            existing.close();
+        if (size + logBuffer.size() > RANGETEST_LOG_MAX_BYTES) {
+            LOG_INFO("Range test log reached %u bytes, starting a new one\n", size);
+            if (FSCom.exists("/static/rangetest.1.csv"))
+                FSCom.remove("/static/rangetest.1.csv");
+            renameFile("/static/rangetest.csv", "/static/rangetest.1.csv");
+            newFile = true;
+        }
+    }
+
+    File fileToAppend = FSCom.open("/static/rangetest.csv", RANGETEST_FILE_APPEND);
+    if (!fileToAppend) {
+        LOG_ERROR("There was an error opening the file for appending\n");
+        return;
+    }
+
+    if (newFile) {
+        // Print the CSV header
+        fileToAppend.print(
+            "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload\n");
+    }
+
+    if (fileToAppend.write((const uint8_t *)logBuffer.data(), logBuffer.size()) != logBuffer.size())
+        LOG_ERROR("File write failed\n");
     fileToAppend.flush();
     fileToAppend.close();
+    logBuffer.clear();
 #endif
-
-    return 1;
-}
\ No newline at end of file
+}
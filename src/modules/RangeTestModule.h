@@ -1,10 +1,41 @@
 #pragma once
 
+#include "Observer.h"
 #include "SinglePortModule.h"
 #include "concurrency/OSThread.h"
 #include "configuration.h"
 #include <Arduino.h>
 #include <functional>
+#include <string>
+
+// Received rows are kept in RAM and written out together once there are this many bytes of them
+#ifndef RANGETEST_LOG_FLUSH_BYTES
+#define RANGETEST_LOG_FLUSH_BYTES 1024
+#endif
+
+// ... or the oldest of them is this old
+#ifndef RANGETEST_LOG_FLUSH_MSEC
+#define RANGETEST_LOG_FLUSH_MSEC (30 * 1000)
+#endif
+
+// Once the log grows past this it is moved to rangetest.1.csv and a new one is started. The nRF52 filesystem is only
+// about 28 KB and holds our preferences too, so both copies of the log have to stay small there
+#ifndef RANGETEST_LOG_MAX_BYTES
+#ifdef ARCH_NRF52
+#define RANGETEST_LOG_MAX_BYTES (4 * 1024)
+#else
+#define RANGETEST_LOG_MAX_BYTES (256 * 1024)
+#endif
+#endif
+
+// Rows are dropped rather than written while the filesystem has less than this left, so preferences can still be saved
+#ifndef RANGETEST_LOG_MIN_FREE_BYTES
+#ifdef ARCH_NRF52
+#define RANGETEST_LOG_MIN_FREE_BYTES (12 * 1024)
+#else
+#define RANGETEST_LOG_MIN_FREE_BYTES (50 * 1024)
+#endif
+#endif
 
 class RangeTestModule : private concurrency::OSThread
 {
@@ -27,23 +58,36 @@ extern RangeTestModule *rangeTestModule;
 class RangeTestModuleRadio : public SinglePortModule
 {
     uint32_t lastRxID = 0;
+    std::string logBuffer;       // CSV rows not yet written to the Filesystem
+    uint32_t logBufferSince = 0; // millis() when the oldest of them was added
 
-  public:
-    RangeTestModuleRadio() : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP)
+    CallbackObserver<RangeTestModuleRadio, void *> notifyDeepSleepObserver =
+        CallbackObserver<RangeTestModuleRadio, void *>(this, &RangeTestModuleRadio::notifyDeepSleepCb);
+
+    int notifyDeepSleepCb(void *unused = NULL)
     {
-        loopbackOk = true; // Allow locally generated messages to loop back to the client
+        flushFile();
+        return 0;
     }
 
+  public:
+    RangeTestModuleRadio();
+
     /**
      * Send our payload into the mesh
      */
     void sendPayload(NodeNum dest = NODENUM_BROADCAST, bool wantReplies = false);
 
     /**
-     * Append range test data to the file on the Filesystem
+     * Append range test data to the file on the Filesystem. Rows are buffered, see flushFile()
      */
     bool appendFile(const meshtastic_MeshPacket &mp);
 
+    /**
+     * Write out the buffered rows. Unless force is set, only once RANGETEST_LOG_FLUSH_MSEC has passed
+     */
+    void flushFile(bool force = true);
+
   protected:
     /** Called to handle a particular incoming message
 
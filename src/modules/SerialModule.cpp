@@ -41,6 +41,13 @@
           state. Device connected to that pin may see this as "noise".
         * Will not work on Linux device targets.
 
+    TUNNEL (build with SERIAL_TUNNEL=1, see SerialModule.h)
+        SIMPLE mode becomes a tunnel for devices that push binary bursts. UART bytes are coalesced into frames of up to
+        SERIAL_TUNNEL_MTU bytes, each numbered and sent with want_ack to the peer set with SERIAL_TUNNEL_DEST, which each
+        end must be built with. At most SERIAL_TUNNEL_WINDOW frames are in flight.
+        The receiver writes them out in order and drops duplicates. While the window or the radio's tx queue is full we
+        stop reading the UART and hold the device off with RTS or XOFF.
+
 
 */
 
@@ -139,7 +146,14 @@ int32_t SerialModule::runOnce()
 #ifdef ARCH_ESP32
 
             if (moduleConfig.serial.rxd && moduleConfig.serial.txd) {
+#if SERIAL_TUNNEL
+                // Room for the bytes that keep coming while we hold the device off
+                Serial2.setRxBufferSize(moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_SIMPLE
+                                            ? SERIAL_TUNNEL_RX_BUFFER
+                                            : RX_BUFFER);
+#else
                 Serial2.setRxBufferSize(RX_BUFFER);
+#endif
                 Serial2.begin(baud, SERIAL_8N1, moduleConfig.serial.rxd, moduleConfig.serial.txd);
             } else {
                 Serial.begin(baud);
@@ -170,6 +184,11 @@ int32_t SerialModule::runOnce()
 #endif
             serialModuleRadio = new SerialModuleRadio();
 
+#if SERIAL_TUNNEL && defined(SERIAL_TUNNEL_RTS_PIN)
+            pinMode(SERIAL_TUNNEL_RTS_PIN, OUTPUT);
+            digitalWrite(SERIAL_TUNNEL_RTS_PIN, LOW);
+#endif
+
             firstTime = 0;
 
             // in API mode send rebooted sequence
@@ -199,6 +218,15 @@ int32_t SerialModule::runOnce()
                 }
             }
 #if !defined(TTGO_T_ECHO) && !defined(CANARYONE)
+#if SERIAL_TUNNEL
+            else if (moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_SIMPLE) {
+                if (SERIAL_TUNNEL_DEST == 0 || SERIAL_TUNNEL_DEST == NODENUM_BROADCAST) {
+                    LOG_ERROR("Serial tunnel needs SERIAL_TUNNEL_DEST set to the node number of its peer, not starting it\n");
+                    return disable();
+                }
+                runTunnel();
+            }
+#endif
             else {
                 while (Serial2.available()) {
                     serialPayloadSize = Serial2.readBytes(serialBytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
@@ -263,6 +291,16 @@ ProcessMessage SerialModuleRadio::handleReceived(const meshtastic_MeshPacket &mp
             return ProcessMessage::CONTINUE;
         }
 
+#if SERIAL_TUNNEL
+        if (moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_SIMPLE) {
+            if (mp.decoded.portnum == meshtastic_PortNum_ROUTING_APP)
+                handleTunnelAck(mp);
+            else if (getFrom(&mp) == SERIAL_TUNNEL_DEST && mp.to == nodeDB->getNodeNum())
+                handleTunnelFrame(mp);
+            return ProcessMessage::CONTINUE;
+        }
+#endif
+
         auto &p = mp.decoded;
         // LOG_DEBUG("Received text msg self=0x%0x, from=0x%0x, to=0x%0x, id=%d, msg=%.*s\n",
         //          nodeDB->getNodeNum(), mp.from, mp.to, mp.id, p.payload.size, p.payload.bytes);
@@ -317,6 +355,195 @@ ProcessMessage SerialModuleRadio::handleReceived(const meshtastic_MeshPacket &mp
     return ProcessMessage::CONTINUE; // Let others look at this message also if they want
 }
 
+#if SERIAL_TUNNEL
+
+#if !defined(TTGO_T_ECHO) && !defined(CANARYONE)
+/**
+ * Coalesce UART bytes into frames and hand them to the radio side, holding the device off while it can't take more.
+ */
+void SerialModule::runTunnel()
+{
+    size_t available = Serial2.available();
+    if (available && tunnelFill < SERIAL_TUNNEL_MTU) {
+        tunnelFill += Serial2.readBytes(tunnelBytes + tunnelFill, min(available, SERIAL_TUNNEL_MTU - tunnelFill));
+        lastTunnelByte = millis();
+    }
+
+    uint32_t idle = moduleConfig.serial.timeout > 0 ? moduleConfig.serial.timeout : TIMEOUT;
+    bool frameDone = tunnelFill == SERIAL_TUNNEL_MTU || (tunnelFill > 0 && millis() - lastTunnelByte >= idle);
+    if (frameDone && serialModuleRadio->tunnelCanSend()) {
+        serialModuleRadio->sendTunnelFrame(tunnelBytes, tunnelFill);
+        tunnelFill = 0;
+    }
+
+    setTunnelPaused(!serialModuleRadio->tunnelCanSend());
+    serialModuleRadio->checkTunnelGaps();
+}
+#endif
+
+void SerialModule::setTunnelPaused(bool paused)
+{
+    if (paused == tunnelPaused)
+        return;
+    tunnelPaused = paused;
+    LOG_DEBUG("Serial tunnel %s\n", paused ? "paused" : "resumed");
+#ifdef SERIAL_TUNNEL_RTS_PIN
+    digitalWrite(SERIAL_TUNNEL_RTS_PIN, paused ? HIGH : LOW);
+#endif
+#if SERIAL_TUNNEL_XONXOFF
+    serialPrint->write(paused ? 0x13 : 0x11);
+#endif
+}
+
+bool SerialModuleRadio::tunnelCanSend()
+{
+    meshtastic_QueueStatus qs = router->getQueueStatus();
+    if (qs.maxlen && qs.free < SERIAL_TUNNEL_MIN_TX_FREE)
+        return false;
+
+    for (auto &f : txFrames)
+        if (!f.used)
+            return true;
+    return false;
+}
+
+void SerialModuleRadio::sendTunnelFrame(const uint8_t *bytes, size_t size)
+{
+    for (auto &f : txFrames) {
+        if (f.used)
+            continue;
+        f.used = true;
+        f.resends = 0;
+        f.seq = txSeq++;
+        f.flags = txStarted ? 0 : SERIAL_TUNNEL_FLAG_START;
+        f.size = size;
+        memcpy(f.bytes, bytes, size);
+        txStarted = true;
+        transmitTunnelFrame(f);
+        return;
+    }
+}
+
+void SerialModuleRadio::transmitTunnelFrame(TunnelFrame &f)
+{
+    const meshtastic_Channel *ch = (boundChannel != NULL) ? &channels.getByName(boundChannel) : NULL;
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = SERIAL_TUNNEL_DEST;
+    if (ch != NULL) {
+        p->channel = ch->index;
+    }
+    p->want_ack = true;
+
+    p->decoded.payload.bytes[0] = f.seq & 0xff;
+    p->decoded.payload.bytes[1] = f.seq >> 8;
+    p->decoded.payload.bytes[2] = f.flags;
+    memcpy(p->decoded.payload.bytes + SERIAL_TUNNEL_HEADER_LEN, f.bytes, f.size);
+    p->decoded.payload.size = SERIAL_TUNNEL_HEADER_LEN + f.size;
+
+    f.id = p->id;
+    service.sendToMesh(p);
+}
+
+/**
+ * An ack frees the frame's slot in the window. If the router gave up on it we send it again, the receiver drops
+ * the copy if the first one did get through.
+ */
+void SerialModuleRadio::handleTunnelAck(const meshtastic_MeshPacket &mp)
+{
+    if (!mp.decoded.request_id)
+        return;
+
+    for (auto &f : txFrames) {
+        if (!f.used || f.id != mp.decoded.request_id)
+            continue;
+
+        meshtastic_Routing routing = meshtastic_Routing_init_zero;
+        pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, &meshtastic_Routing_msg, &routing);
+        if (routing.which_variant != meshtastic_Routing_error_reason_tag ||
+            routing.error_reason == meshtastic_Routing_Error_NONE) {
+            f.used = false;
+        } else if (f.resends < SERIAL_TUNNEL_MAX_RESENDS) {
+            f.resends++;
+            LOG_DEBUG("Serial tunnel frame %u failed (%d), sending again\n", f.seq, routing.error_reason);
+            transmitTunnelFrame(f);
+        } else {
+            LOG_WARN("Serial tunnel frame %u failed (%d), dropping it\n", f.seq, routing.error_reason);
+            f.used = false;
+        }
+        return;
+    }
+}
+
+void SerialModuleRadio::handleTunnelFrame(const meshtastic_MeshPacket &mp)
+{
+    auto &p = mp.decoded.payload;
+    if (p.size < SERIAL_TUNNEL_HEADER_LEN)
+        return;
+    uint16_t seq = p.bytes[0] | (p.bytes[1] << 8);
+    uint8_t flags = p.bytes[2];
+
+    // The tunnel is point to point, our peer rebooting restarts the stream
+    NodeNum from = getFrom(&mp);
+    if (from != rxPeer || (flags & SERIAL_TUNNEL_FLAG_START)) {
+        for (auto &f : rxFrames)
+            f.used = false;
+        rxPeer = from;
+        rxSeq = seq;
+    }
+
+    int16_t ahead = seq - rxSeq;
+    if (ahead < 0)
+        return; // A resend of a frame we already wrote out
+
+    if (ahead >= SERIAL_TUNNEL_WINDOW) {
+        // Further ahead than we can hold, stop waiting for what is missing
+        LOG_WARN("Serial tunnel skipping to frame %u, frames from %u are lost\n", seq, rxSeq);
+        for (uint16_t i = 0; i < SERIAL_TUNNEL_WINDOW; i++) {
+            TunnelFrame &held = rxFrames[(uint16_t)(rxSeq + i) % SERIAL_TUNNEL_WINDOW];
+            if (held.used && held.seq == (uint16_t)(rxSeq + i)) {
+                serialPrint->write(held.bytes, held.size);
+                held.used = false;
+            }
+        }
+        rxSeq = seq;
+    }
+
+    TunnelFrame &f = rxFrames[seq % SERIAL_TUNNEL_WINDOW];
+    f.used = true;
+    f.seq = seq;
+    f.arrived = millis();
+    f.size = p.size - SERIAL_TUNNEL_HEADER_LEN;
+    memcpy(f.bytes, p.bytes + SERIAL_TUNNEL_HEADER_LEN, f.size);
+    writeTunnelFrames();
+}
+
+/// Write out held frames for as long as they follow on from rxSeq
+void SerialModuleRadio::writeTunnelFrames()
+{
+    TunnelFrame *f;
+    while ((f = &rxFrames[rxSeq % SERIAL_TUNNEL_WINDOW])->used && f->seq == rxSeq) {
+        serialPrint->write(f->bytes, f->size);
+        f->used = false;
+        rxSeq++;
+    }
+}
+
+void SerialModuleRadio::checkTunnelGaps()
+{
+    uint32_t now = millis();
+    for (auto &f : rxFrames) {
+        if (f.used && now - f.arrived >= SERIAL_TUNNEL_GAP_MSEC) {
+            LOG_WARN("Serial tunnel gave up waiting for frame %u\n", rxSeq);
+            while (!rxFrames[rxSeq % SERIAL_TUNNEL_WINDOW].used)
+                rxSeq++;
+            writeTunnelFrames();
+            return;
+        }
+    }
+}
+
+#endif
+
 /**
  * @brief Returns the baud rate of the serial module from the module configuration.
  *
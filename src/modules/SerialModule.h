@@ -11,6 +11,51 @@
 #if (defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)) && !defined(CONFIG_IDF_TARGET_ESP32S2) &&               \
     !defined(CONFIG_IDF_TARGET_ESP32C3)
 
+// Build with SERIAL_TUNNEL=1 to carry SIMPLE mode over a framed tunnel: UART bytes are coalesced into full packets, numbered,
+// acknowledged and written out in order on the far side. Both ends must be built with it
+#ifndef SERIAL_TUNNEL
+#define SERIAL_TUNNEL 0
+#endif
+
+#if SERIAL_TUNNEL
+#define SERIAL_TUNNEL_HEADER_LEN 3 // seq (little endian uint16), flags
+#define SERIAL_TUNNEL_FLAG_START 1 // First frame since the sender booted, the receiver restarts its sequence here
+
+// Most UART bytes per frame. A frame goes out once it is full or the line has been quiet for moduleConfig.serial.timeout
+#ifndef SERIAL_TUNNEL_MTU
+#define SERIAL_TUNNEL_MTU (meshtastic_Constants_DATA_PAYLOAD_LEN - SERIAL_TUNNEL_HEADER_LEN)
+#endif
+// Frames in flight without an ack, and frames the receiver holds while waiting for a missing one. A power of two
+#ifndef SERIAL_TUNNEL_WINDOW
+#define SERIAL_TUNNEL_WINDOW 4
+#endif
+// Node number of the other end of the tunnel. It has to be set, as broadcast frames would only be acked by the first node
+// that rebroadcasts them rather than by the peer. Without it the tunnel doesn't start
+#ifndef SERIAL_TUNNEL_DEST
+#define SERIAL_TUNNEL_DEST 0
+#endif
+// Times we send a frame again after the router gave up on it, before we drop it
+#ifndef SERIAL_TUNNEL_MAX_RESENDS
+#define SERIAL_TUNNEL_MAX_RESENDS 2
+#endif
+// How long the receiver waits for a missing frame before writing out what came after it
+#ifndef SERIAL_TUNNEL_GAP_MSEC
+#define SERIAL_TUNNEL_GAP_MSEC (60 * 1000)
+#endif
+// Stop taking UART bytes while fewer than this many slots are free in the radio's tx queue
+#ifndef SERIAL_TUNNEL_MIN_TX_FREE
+#define SERIAL_TUNNEL_MIN_TX_FREE 4
+#endif
+#ifndef SERIAL_TUNNEL_RX_BUFFER
+#define SERIAL_TUNNEL_RX_BUFFER 1024
+#endif
+// Flow control towards the UART device: define SERIAL_TUNNEL_RTS_PIN for RTS (high means stop), or set
+// SERIAL_TUNNEL_XONXOFF to send XOFF/XON. XON/XOFF is off by default as those bytes can also appear in tunnelled data
+#ifndef SERIAL_TUNNEL_XONXOFF
+#define SERIAL_TUNNEL_XONXOFF 0
+#endif
+#endif
+
 class SerialModule : public StreamAPI, private concurrency::OSThread
 {
     bool firstTime = 1;
@@ -28,6 +73,17 @@ class SerialModule : public StreamAPI, private concurrency::OSThread
 
   private:
     uint32_t getBaudRate();
+
+#if SERIAL_TUNNEL
+    // UART bytes wait here until they fill a frame or the line goes quiet
+    uint8_t tunnelBytes[SERIAL_TUNNEL_MTU];
+    size_t tunnelFill = 0;
+    uint32_t lastTunnelByte = 0;
+    bool tunnelPaused = false;
+
+    void runTunnel();
+    void setTunnelPaused(bool paused);
+#endif
 };
 
 extern SerialModule *serialModule;
@@ -49,6 +105,17 @@ class SerialModuleRadio : public MeshModule
      */
     void sendPayload(NodeNum dest = NODENUM_BROADCAST, bool wantReplies = false);
 
+#if SERIAL_TUNNEL
+    /// Is there room for another frame? False while the window is full or the radio's tx queue is close to full
+    bool tunnelCanSend();
+
+    /// Send UART bytes as the next frame of the tunnel
+    void sendTunnelFrame(const uint8_t *bytes, size_t size);
+
+    /// Stop waiting for a missing frame once SERIAL_TUNNEL_GAP_MSEC has passed, and write out what came after it
+    void checkTunnelGaps();
+#endif
+
   protected:
     virtual meshtastic_MeshPacket *allocReply() override;
 
@@ -61,7 +128,16 @@ class SerialModuleRadio : public MeshModule
 
     meshtastic_PortNum ourPortNum;
 
-    virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return p->decoded.portnum == ourPortNum; }
+    virtual bool wantPacket(const meshtastic_MeshPacket *p) override
+    {
+#if SERIAL_TUNNEL
+        // We need the acks for our frames
+        if (moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_SIMPLE &&
+            p->decoded.portnum == meshtastic_PortNum_ROUTING_APP)
+            return true;
+#endif
+        return p->decoded.portnum == ourPortNum;
+    }
 
     meshtastic_MeshPacket *allocDataPacket()
     {
@@ -71,6 +147,31 @@ class SerialModuleRadio : public MeshModule
 
         return p;
     }
+
+#if SERIAL_TUNNEL
+    struct TunnelFrame {
+        bool used;
+        PacketId id;      // Mesh packet that last carried it (sending side)
+        uint32_t arrived; // millis() it arrived (receiving side)
+        uint8_t resends;
+        uint16_t seq;
+        uint8_t flags;
+        uint8_t size;
+        uint8_t bytes[SERIAL_TUNNEL_MTU];
+    };
+
+    TunnelFrame txFrames[SERIAL_TUNNEL_WINDOW] = {}; // Sent and not acked yet
+    TunnelFrame rxFrames[SERIAL_TUNNEL_WINDOW] = {}; // Arrived ahead of a missing frame, at seq % SERIAL_TUNNEL_WINDOW
+    uint16_t txSeq = 0;
+    bool txStarted = false;
+    NodeNum rxPeer = 0; // Whose stream we are writing out
+    uint16_t rxSeq = 0; // Next frame we write out
+
+    void transmitTunnelFrame(TunnelFrame &f);
+    void handleTunnelAck(const meshtastic_MeshPacket &mp);
+    void handleTunnelFrame(const meshtastic_MeshPacket &mp);
+    void writeTunnelFrames();
+#endif
 };
 
 extern SerialModuleRadio *serialModuleRadio;
@@ -6,6 +6,7 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "Router.h"
+#include "TelemetryHistory.h"
 #include "configuration.h"
 #include "main.h"
 #include <OLEDDisplay.h>
@@ -16,6 +17,7 @@
 int32_t DeviceTelemetryModule::runOnce()
 {
     refreshUptime();
+    telemetryHistory.record(getDeviceTelemetry());
     if (((lastSentToMesh == 0) ||
          ((uptimeLastMs - lastSentToMesh) >= Default::getConfiguredOrDefaultMs(moduleConfig.telemetry.device_update_interval))) &&
         airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
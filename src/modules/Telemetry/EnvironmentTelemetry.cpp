@@ -6,6 +6,7 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "Router.h"
+#include "TelemetryHistory.h"
 #include "configuration.h"
 #include "main.h"
 #include "power.h"
@@ -36,6 +37,19 @@ SHT31Sensor sht31Sensor;
 #define FAILED_STATE_SENSOR_READ_MULTIPLIER 10
 #define DISPLAY_RECEIVEID_MEASUREMENTS_ON_SCREEN true
 
+// Readings averaged into each report, spread evenly over the shorter of the mesh and phone report intervals
+#ifndef ENVIRONMENT_SAMPLES_PER_REPORT
+#define ENVIRONMENT_SAMPLES_PER_REPORT 4
+#endif
+
+// In the order their readings are applied, later sensors win when two measure the same thing
+static TelemetrySensor *const sampledSensors[] = {&sht31Sensor,  &lps22hbSensor, &shtc3Sensor,   &bmp085Sensor, &bmp280Sensor,
+                                                  &bme280Sensor, &bme680Sensor,  &mcp9808Sensor, &ina219Sensor, &ina260Sensor};
+#define NUM_SAMPLED_SENSORS (sizeof(sampledSensors) / sizeof(sampledSensors[0]))
+
+// When each sensor's conversion for the current sampling round will be ready
+static uint32_t sensorReadyAt[NUM_SAMPLED_SENSORS];
+
 #include "graphics/ScreenFonts.h"
 
 int32_t EnvironmentTelemetryModule::runOnce()
@@ -115,10 +129,74 @@ int32_t EnvironmentTelemetryModule::runOnce()
             sendTelemetry(NODENUM_BROADCAST, true);
             lastSentToPhone = now;
         }
+        result = min(result, sampleSensors());
     }
     return min(sendToPhoneIntervalMs, result);
 }
 
+uint32_t EnvironmentTelemetryModule::getSamplePeriodMs()
+{
+    uint32_t reportIntervalMs = Default::getConfiguredOrDefaultMs(moduleConfig.telemetry.environment_update_interval);
+    return min(reportIntervalMs, sendToPhoneIntervalMs) / ENVIRONMENT_SAMPLES_PER_REPORT;
+}
+
+/**
+ * One step of background sampling: start a conversion on every sensor, then collect the results one sensor per call
+ * as each becomes ready, returning to the main loop in between. Returns the msec until the next step is due.
+ */
+uint32_t EnvironmentTelemetryModule::sampleSensors()
+{
+    uint32_t now = millis();
+    if (!sampling) {
+        uint32_t sinceLastSample = now - lastSampleStart;
+        if (lastSampleStart != 0 && sinceLastSample < getSamplePeriodMs())
+            return getSamplePeriodMs() - sinceLastSample;
+
+        // A round only counts if every present sensor reads, so fields of a failed sensor never drag the average to 0
+        sampleRoundValid = false;
+        for (size_t i = 0; i < NUM_SAMPLED_SENSORS; i++) {
+            sensorReadyAt[i] = sampledSensors[i]->hasSensor() ? now + sampledSensors[i]->startMeasurement() : now;
+            sampleRoundValid |= sampledSensors[i]->hasSensor();
+        }
+        memset(&sampleRound, 0, sizeof(sampleRound));
+        sampleRound.which_variant = meshtastic_Telemetry_environment_metrics_tag;
+        nextSensor = 0;
+        sampling = true;
+        lastSampleStart = now;
+    }
+
+    while (nextSensor < NUM_SAMPLED_SENSORS && !sampledSensors[nextSensor]->hasSensor())
+        nextSensor++;
+
+    if (nextSensor < NUM_SAMPLED_SENSORS) {
+        int32_t wait = sensorReadyAt[nextSensor] - now;
+        if (wait > 0)
+            return wait;
+        if (!sampledSensors[nextSensor]->getMetrics(&sampleRound)) {
+            LOG_WARN("Environment sensor %u failed to read, dropping this sample\n", (unsigned)nextSensor);
+            sampleRoundValid = false;
+        }
+        nextSensor++;
+        return 0;
+    }
+
+    sampling = false;
+    if (sampleRoundValid) {
+        const meshtastic_EnvironmentMetrics &s = sampleRound.variant.environment_metrics;
+        sampleSum.temperature += s.temperature;
+        sampleSum.relative_humidity += s.relative_humidity;
+        sampleSum.barometric_pressure += s.barometric_pressure;
+        sampleSum.gas_resistance += s.gas_resistance;
+        sampleSum.voltage += s.voltage;
+        sampleSum.current += s.current;
+        sampleSum.distance += s.distance;
+        sampleIaqSum += s.iaq;
+        sampleCount++;
+        telemetryHistory.record(sampleRound);
+    }
+    return getSamplePeriodMs();
+}
+
 bool EnvironmentTelemetryModule::wantUIFrame()
 {
     return moduleConfig.telemetry.environment_screen_enabled;
@@ -221,26 +299,31 @@ bool EnvironmentTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
     m.variant.environment_metrics.temperature = 0;
     m.variant.environment_metrics.voltage = 0;
 
-    if (sht31Sensor.hasSensor())
-        valid = sht31Sensor.getMetrics(&m);
-    if (lps22hbSensor.hasSensor())
-        valid = lps22hbSensor.getMetrics(&m);
-    if (shtc3Sensor.hasSensor())
-        valid = shtc3Sensor.getMetrics(&m);
-    if (bmp085Sensor.hasSensor())
-        valid = bmp085Sensor.getMetrics(&m);
-    if (bmp280Sensor.hasSensor())
-        valid = bmp280Sensor.getMetrics(&m);
-    if (bme280Sensor.hasSensor())
-        valid = bme280Sensor.getMetrics(&m);
-    if (bme680Sensor.hasSensor())
-        valid = bme680Sensor.getMetrics(&m);
-    if (mcp9808Sensor.hasSensor())
-        valid = mcp9808Sensor.getMetrics(&m);
-    if (ina219Sensor.hasSensor())
-        valid = ina219Sensor.getMetrics(&m);
-    if (ina260Sensor.hasSensor())
-        valid = ina260Sensor.getMetrics(&m);
+    if (sampleCount > 0) {
+        // Report the average of what the background sampling collected since we last sent to the mesh
+        LOG_DEBUG("Averaging %u environment samples\n", sampleCount);
+        m.variant.environment_metrics = sampleSum;
+        m.variant.environment_metrics.temperature /= sampleCount;
+        m.variant.environment_metrics.relative_humidity /= sampleCount;
+        m.variant.environment_metrics.barometric_pressure /= sampleCount;
+        m.variant.environment_metrics.gas_resistance /= sampleCount;
+        m.variant.environment_metrics.voltage /= sampleCount;
+        m.variant.environment_metrics.current /= sampleCount;
+        m.variant.environment_metrics.distance /= sampleCount;
+        m.variant.environment_metrics.iaq = sampleIaqSum / sampleCount;
+        if (!phoneOnly) {
+            memset(&sampleSum, 0, sizeof(sampleSum));
+            sampleIaqSum = 0;
+            sampleCount = 0;
+        }
+        valid = true;
+    } else {
+        // Nothing sampled yet, read the sensors directly
+        for (size_t i = 0; i < NUM_SAMPLED_SENSORS; i++) {
+            if (sampledSensors[i]->hasSensor())
+                valid = sampledSensors[i]->getMetrics(&m);
+        }
+    }
 
     if (valid) {
         LOG_INFO("(Sending): barometric_pressure=%f, current=%f, gas_resistance=%f, relative_humidity=%f, temperature=%f, "
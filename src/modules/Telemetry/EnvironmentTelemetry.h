@@ -41,4 +41,16 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     uint32_t lastSentToMesh = 0;
     uint32_t lastSentToPhone = 0;
     uint32_t sensor_read_error_count = 0;
+
+    // Background sampling, see sampleSensors()
+    uint32_t sampleSensors();
+    uint32_t getSamplePeriodMs();
+    bool sampling = false;            // A round has been started and not all sensors collected yet
+    size_t nextSensor = 0;            // Next sensor to collect in this round
+    uint32_t lastSampleStart = 0;     // millis() when the last round was started
+    meshtastic_Telemetry sampleRound; // Readings of the round in progress
+    bool sampleRoundValid = false;
+    meshtastic_EnvironmentMetrics sampleSum = meshtastic_EnvironmentMetrics_init_zero; // Sum of the completed rounds
+    uint32_t sampleIaqSum = 0;                                                         // iaq is too narrow to sum in place
+    uint32_t sampleCount = 0;
 };
@@ -5,6 +5,9 @@
 #include <Adafruit_BME280.h>
 #include <typeinfo>
 
+// Worst-case conversion time with X1 oversampling, from the datasheet
+#define BME280_FORCED_MSEC 10
+
 BME280Sensor::BME280Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_BME280, "BME280") {}
 
 int32_t BME280Sensor::runOnce()
@@ -15,21 +18,36 @@ int32_t BME280Sensor::runOnce()
     }
     status = bme280.begin(nodeTelemetrySensorsMap[sensorType].first, nodeTelemetrySensorsMap[sensorType].second);
 
+    setForcedSampling();
+
+    return initI2CSensor();
+}
+
+void BME280Sensor::setup() {}
+
+// Writing the control register in forced mode starts a single conversion, after which the sensor goes back to sleep
+void BME280Sensor::setForcedSampling()
+{
     bme280.setSampling(Adafruit_BME280::MODE_FORCED,
                        Adafruit_BME280::SAMPLING_X1, // Temp. oversampling
                        Adafruit_BME280::SAMPLING_X1, // Pressure oversampling
                        Adafruit_BME280::SAMPLING_X1, // Humidity oversampling
                        Adafruit_BME280::FILTER_OFF, Adafruit_BME280::STANDBY_MS_1000);
-
-    return initI2CSensor();
 }
 
-void BME280Sensor::setup() {}
+uint32_t BME280Sensor::startMeasurement()
+{
+    setForcedSampling();
+    measurementStarted = true;
+    return BME280_FORCED_MSEC;
+}
 
 bool BME280Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     LOG_DEBUG("BME280Sensor::getMetrics\n");
-    bme280.takeForcedMeasurement();
+    if (!measurementStarted)
+        bme280.takeForcedMeasurement();
+    measurementStarted = false;
     measurement->variant.environment_metrics.temperature = bme280.readTemperature();
     measurement->variant.environment_metrics.relative_humidity = bme280.readHumidity();
     measurement->variant.environment_metrics.barometric_pressure = bme280.readPressure() / 100.0F;
@@ -6,6 +6,9 @@ class BME280Sensor : public TelemetrySensor
 {
   private:
     Adafruit_BME280 bme280;
+    bool measurementStarted = false;
+
+    void setForcedSampling();
 
   protected:
     virtual void setup() override;
@@ -13,5 +16,6 @@ class BME280Sensor : public TelemetrySensor
   public:
     BME280Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
\ No newline at end of file
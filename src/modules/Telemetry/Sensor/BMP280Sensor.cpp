@@ -5,6 +5,9 @@
 #include <Adafruit_BMP280.h>
 #include <typeinfo>
 
+// Worst-case conversion time with X1 oversampling, from the datasheet
+#define BMP280_FORCED_MSEC 7
+
 BMP280Sensor::BMP280Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_BMP280, "BMP280") {}
 
 int32_t BMP280Sensor::runOnce()
@@ -16,20 +19,35 @@ int32_t BMP280Sensor::runOnce()
     bmp280 = Adafruit_BMP280(nodeTelemetrySensorsMap[sensorType].second);
     status = bmp280.begin(nodeTelemetrySensorsMap[sensorType].first);
 
+    setForcedSampling();
+
+    return initI2CSensor();
+}
+
+void BMP280Sensor::setup() {}
+
+// Writing the control register in forced mode starts a single conversion, after which the sensor goes back to sleep
+void BMP280Sensor::setForcedSampling()
+{
     bmp280.setSampling(Adafruit_BMP280::MODE_FORCED,
                        Adafruit_BMP280::SAMPLING_X1, // Temp. oversampling
                        Adafruit_BMP280::SAMPLING_X1, // Pressure oversampling
                        Adafruit_BMP280::FILTER_OFF, Adafruit_BMP280::STANDBY_MS_1000);
-
-    return initI2CSensor();
 }
 
-void BMP280Sensor::setup() {}
+uint32_t BMP280Sensor::startMeasurement()
+{
+    setForcedSampling();
+    measurementStarted = true;
+    return BMP280_FORCED_MSEC;
+}
 
 bool BMP280Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     LOG_DEBUG("BMP280Sensor::getMetrics\n");
-    bmp280.takeForcedMeasurement();
+    if (!measurementStarted)
+        bmp280.takeForcedMeasurement();
+    measurementStarted = false;
     measurement->variant.environment_metrics.temperature = bmp280.readTemperature();
     measurement->variant.environment_metrics.barometric_pressure = bmp280.readPressure() / 100.0F;
 
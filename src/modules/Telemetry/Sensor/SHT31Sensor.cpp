@@ -3,6 +3,11 @@
 #include "TelemetrySensor.h"
 #include "configuration.h"
 #include <Adafruit_SHT31.h>
+#include <Wire.h>
+
+// Single shot, high repeatability, no clock stretching. The result is ready within 15.5 msec
+static const uint16_t SHT31_SINGLE_SHOT_HIGHREP = 0x2400;
+static const uint32_t SHT31_SINGLE_SHOT_MSEC = 16;
 
 SHT31Sensor::SHT31Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_SHT31, "SHT31") {}
 
@@ -22,10 +27,59 @@ void SHT31Sensor::setup()
     // Set up oversampling and filter initialization
 }
 
+uint32_t SHT31Sensor::startMeasurement()
+{
+    TwoWire *wire = nodeTelemetrySensorsMap[sensorType].second;
+    wire->beginTransmission(nodeTelemetrySensorsMap[sensorType].first);
+    wire->write(SHT31_SINGLE_SHOT_HIGHREP >> 8);
+    wire->write(SHT31_SINGLE_SHOT_HIGHREP & 0xff);
+    measurementStarted = (wire->endTransmission() == 0);
+    return measurementStarted ? SHT31_SINGLE_SHOT_MSEC : 0;
+}
+
+static uint8_t sht31Crc(const uint8_t *data)
+{
+    uint8_t crc = 0xff;
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+    }
+    return crc;
+}
+
+// Collect the result of the conversion kicked off by startMeasurement()
+bool SHT31Sensor::readMeasurement(float &temperature, float &humidity)
+{
+    TwoWire *wire = nodeTelemetrySensorsMap[sensorType].second;
+    uint8_t data[6];
+    if (wire->requestFrom(nodeTelemetrySensorsMap[sensorType].first, (uint8_t)sizeof(data)) != sizeof(data))
+        return false;
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = wire->read();
+    if (sht31Crc(data) != data[2] || sht31Crc(data + 3) != data[5]) {
+        LOG_WARN("%s: CRC mismatch\n", sensorName);
+        return false;
+    }
+
+    temperature = -45.0f + 175.0f * ((data[0] << 8) | data[1]) / 65535.0f;
+    humidity = 100.0f * ((data[3] << 8) | data[4]) / 65535.0f;
+    return true;
+}
+
 bool SHT31Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
-    measurement->variant.environment_metrics.temperature = sht31.readTemperature();
-    measurement->variant.environment_metrics.relative_humidity = sht31.readHumidity();
+    float temperature, humidity;
+    if (measurementStarted) {
+        measurementStarted = false;
+        if (!readMeasurement(temperature, humidity))
+            return false;
+    } else if (!sht31.readBoth(&temperature, &humidity)) {
+        return false;
+    }
+
+    measurement->variant.environment_metrics.temperature = temperature;
+    measurement->variant.environment_metrics.relative_humidity = humidity;
 
     return true;
 }
@@ -6,6 +6,9 @@ class SHT31Sensor : public TelemetrySensor
 {
   private:
     Adafruit_SHT31 sht31;
+    bool measurementStarted = false;
+
+    bool readMeasurement(float &temperature, float &humidity);
 
   protected:
     virtual void setup() override;
@@ -13,5 +16,6 @@ class SHT31Sensor : public TelemetrySensor
   public:
     SHT31Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
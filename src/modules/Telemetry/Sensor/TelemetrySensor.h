@@ -44,5 +44,11 @@ class TelemetrySensor
     virtual bool isInitialized() { return initialized; }
     virtual bool isRunning() { return status > 0; }
 
+    /**
+     * Start a conversion and return how many msec until getMetrics() can collect it without waiting.
+     * Sensors whose driver can't split the two return 0 and do the whole measurement in getMetrics().
+     */
+    virtual uint32_t startMeasurement() { return 0; }
+
     virtual bool getMetrics(meshtastic_Telemetry *measurement) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "TelemetryHistory.h"
+#include "RTC.h"
+#include "mqtt/JSON.h"
+#ifdef ARCH_PORTDUINO
+#include "FSCommon.h"
+#endif
+
+TelemetryHistory telemetryHistory;
+
+#define MAGIC_USB_BATTERY_LEVEL 101
+
+void TelemetryHistory::record(const meshtastic_Telemetry &t)
+{
+    uint32_t now = getValidTime(RTCQualityDevice);
+    if (!now)
+        return;
+
+    if (t.which_variant == meshtastic_Telemetry_device_metrics_tag) {
+        const meshtastic_DeviceMetrics &m = t.variant.device_metrics;
+        if (m.battery_level <= 100) // Not while on USB power
+            record(METRIC_BATTERY_LEVEL, m.battery_level, now);
+        record(METRIC_VOLTAGE, m.voltage, now);
+        record(METRIC_CHANNEL_UTILIZATION, m.channel_utilization, now);
+        record(METRIC_AIR_UTIL_TX, m.air_util_tx, now);
+    } else if (t.which_variant == meshtastic_Telemetry_environment_metrics_tag) {
+        // Environment metrics have no presence flags, zero means no sensor measured it
+        const meshtastic_EnvironmentMetrics &m = t.variant.environment_metrics;
+        if (m.temperature != 0)
+            record(METRIC_TEMPERATURE, m.temperature, now);
+        if (m.relative_humidity != 0)
+            record(METRIC_RELATIVE_HUMIDITY, m.relative_humidity, now);
+        if (m.barometric_pressure != 0)
+            record(METRIC_BAROMETRIC_PRESSURE, m.barometric_pressure, now);
+    }
+}
+
+void TelemetryHistory::record(TelemetryMetric metric, float value, uint32_t time)
+{
+#if !TELEMETRY_HISTORY
+    return;
+#endif
+#ifdef ARCH_PORTDUINO
+    if (!loaded)
+        loadFromDisk();
+#endif
+
+    Series *s = series[metric];
+    if (!s) {
+        s = new Series();
+        series[metric] = s;
+    }
+
+    s->raw[s->rawNext] = {time, value};
+    s->rawNext = (s->rawNext + 1) % TELEMETRY_HISTORY_RAW;
+    if (s->rawCount < TELEMETRY_HISTORY_RAW)
+        s->rawCount++;
+
+    s->minutes.add(value, time);
+    s->quarters.add(value, time);
+    s->hours.add(value, time);
+
+#ifdef ARCH_PORTDUINO
+    if (time - lastSave >= SEC_PER_HOUR)
+        saveToDisk();
+#endif
+}
+
+template <size_t N, uint32_t WIDTH> void TelemetryHistory::Tier<N, WIDTH>::add(float value, uint32_t time)
+{
+    uint32_t index = time / WIDTH;
+    if (newest == 0 || index > newest) {
+        // Clear the buckets we are moving past, all of them if the gap is longer than we keep
+        uint32_t skipped = (newest == 0) ? N : min(index - newest, (uint32_t)N);
+        for (uint32_t i = 0; i < skipped; i++)
+            buckets[(index - i) % N] = {};
+        newest = index;
+    } else if (newest - index >= N) {
+        return; // Older than anything we still keep (our clock must have jumped)
+    }
+
+    Aggregate &b = buckets[index % N];
+    if (b.count == 0) {
+        b.min = b.max = value;
+    } else {
+        b.min = min(b.min, value);
+        b.max = max(b.max, value);
+    }
+    b.sum += value;
+    b.count++;
+}
+
+template <size_t N, uint32_t WIDTH>
+size_t TelemetryHistory::Tier<N, WIDTH>::query(uint32_t since, std::vector<TelemetryBucket> &results) const
+{
+    if (newest == 0)
+        return 0;
+
+    size_t added = 0;
+    uint32_t oldest = (newest >= N) ? newest - N + 1 : 0;
+    for (uint32_t i = max(oldest, since / WIDTH); i <= newest; i++) {
+        const Aggregate &b = buckets[i % N];
+        if (b.count) {
+            results.push_back({i * WIDTH, b.min, b.max, b.sum / b.count, b.count});
+            added++;
+        }
+    }
+    return added;
+}
+
+size_t TelemetryHistory::query(TelemetryMetric metric, TelemetryResolution resolution, uint32_t since,
+                               std::vector<TelemetryBucket> &results) const
+{
+    const Series *s = series[metric];
+    if (!s)
+        return 0;
+
+    switch (resolution) {
+    case RESOLUTION_RAW: {
+        size_t added = 0;
+        for (uint16_t i = 0; i < s->rawCount; i++) {
+            const Reading &r = s->raw[(s->rawNext + TELEMETRY_HISTORY_RAW - s->rawCount + i) % TELEMETRY_HISTORY_RAW];
+            if (r.time >= since) {
+                results.push_back({r.time, r.value, r.value, r.value, 1});
+                added++;
+            }
+        }
+        return added;
+    }
+    case RESOLUTION_MINUTE:
+        return s->minutes.query(since, results);
+    case RESOLUTION_QUARTER:
+        return s->quarters.query(since, results);
+    case RESOLUTION_HOUR:
+        return s->hours.query(since, results);
+    default:
+        return 0;
+    }
+}
+
+JSONValue *TelemetryHistory::toJSON(TelemetryResolution resolution, uint32_t since) const
+{
+    // Each metric is a list of [time, min, max, avg, count] buckets, oldest first
+    JSONObject jsonObjMetrics;
+    std::vector<TelemetryBucket> buckets;
+    for (int i = 0; i < NUM_TELEMETRY_METRICS; i++) {
+        buckets.clear();
+        if (!query((TelemetryMetric)i, resolution, since, buckets))
+            continue;
+
+        JSONArray jsonArrayBuckets;
+        for (const TelemetryBucket &b : buckets) {
+            JSONArray jsonArrayBucket;
+            jsonArrayBucket.push_back(new JSONValue((uint)b.time));
+            jsonArrayBucket.push_back(new JSONValue(b.min));
+            jsonArrayBucket.push_back(new JSONValue(b.max));
+            jsonArrayBucket.push_back(new JSONValue(b.avg));
+            jsonArrayBucket.push_back(new JSONValue((int)b.count));
+            jsonArrayBuckets.push_back(new JSONValue(jsonArrayBucket));
+        }
+        jsonObjMetrics[metricName((TelemetryMetric)i)] = new JSONValue(jsonArrayBuckets);
+    }
+
+    JSONObject jsonObj;
+    jsonObj["resolution_seconds"] = new JSONValue((uint)resolutionSeconds(resolution));
+    jsonObj["metrics"] = new JSONValue(jsonObjMetrics);
+    return new JSONValue(jsonObj);
+}
+
+TelemetryResolution TelemetryHistory::parseResolution(const char *name)
+{
+    if (name && strcmp(name, "raw") == 0)
+        return RESOLUTION_RAW;
+    if (name && strcmp(name, "minute") == 0)
+        return RESOLUTION_MINUTE;
+    if (name && strcmp(name, "quarter") == 0)
+        return RESOLUTION_QUARTER;
+    return RESOLUTION_HOUR;
+}
+
+const char *TelemetryHistory::metricName(TelemetryMetric metric)
+{
+    switch (metric) {
+    case METRIC_BATTERY_LEVEL:
+        return "battery_level";
+    case METRIC_VOLTAGE:
+        return "voltage";
+    case METRIC_CHANNEL_UTILIZATION:
+        return "channel_utilization";
+    case METRIC_AIR_UTIL_TX:
+        return "air_util_tx";
+    case METRIC_TEMPERATURE:
+        return "temperature";
+    case METRIC_RELATIVE_HUMIDITY:
+        return "relative_humidity";
+    case METRIC_BAROMETRIC_PRESSURE:
+        return "barometric_pressure";
+    default:
+        return "unknown";
+    }
+}
+
+uint32_t TelemetryHistory::resolutionSeconds(TelemetryResolution resolution)
+{
+    switch (resolution) {
+    case RESOLUTION_MINUTE:
+        return 60;
+    case RESOLUTION_QUARTER:
+        return 15 * 60;
+    case RESOLUTION_HOUR:
+        return 60 * 60;
+    default:
+        return 0;
+    }
+}
+
+#ifdef ARCH_PORTDUINO
+
+static const char *historyFileName = "/prefs/telemetry.dat";
+
+// Written ahead of the series, so a file from a build with different bucket counts is ignored
+struct HistoryFileHeader {
+    uint32_t magic;
+    uint32_t seriesSize;
+};
+static const uint32_t HISTORY_FILE_MAGIC = 0x544c4831; // "TLH1"
+
+void TelemetryHistory::loadFromDisk()
+{
+    loaded = true;
+    lastSave = getValidTime(RTCQualityDevice);
+
+    auto f = FSCom.open(historyFileName, FILE_O_READ);
+    if (!f)
+        return;
+
+    HistoryFileHeader header;
+    if (f.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != HISTORY_FILE_MAGIC ||
+        header.seriesSize != sizeof(Series)) {
+        LOG_WARN("Ignoring incompatible %s\n", historyFileName);
+        f.close();
+        return;
+    }
+
+    for (int i = 0; i < NUM_TELEMETRY_METRICS; i++) {
+        uint8_t present = 0;
+        if (f.read(&present, 1) != 1)
+            break;
+        if (!present)
+            continue;
+        Series *s = new Series();
+        if (f.read((uint8_t *)s, sizeof(Series)) != sizeof(Series)) {
+            delete s;
+            break;
+        }
+        series[i] = s;
+    }
+    f.close();
+    LOG_INFO("Loaded telemetry history from %s\n", historyFileName);
+}
+
+void TelemetryHistory::saveToDisk()
+{
+    lastSave = getValidTime(RTCQualityDevice);
+
+    String filenameTmp = historyFileName;
+    filenameTmp += ".tmp";
+    auto f = FSCom.open(filenameTmp.c_str(), FILE_O_WRITE);
+    if (!f) {
+        LOG_ERROR("Can't write %s\n", historyFileName);
+        return;
+    }
+
+    HistoryFileHeader header = {HISTORY_FILE_MAGIC, sizeof(Series)};
+    f.write((uint8_t *)&header, sizeof(header));
+    for (int i = 0; i < NUM_TELEMETRY_METRICS; i++) {
+        uint8_t present = (series[i] != nullptr);
+        f.write(&present, 1);
+        if (present)
+            f.write((uint8_t *)series[i], sizeof(Series));
+    }
+    f.flush();
+    f.close();
+
+    if (FSCom.exists(historyFileName) && !FSCom.remove(historyFileName))
+        LOG_WARN("Can't remove old %s\n", historyFileName);
+    if (!renameFile(filenameTmp.c_str(), historyFileName))
+        LOG_ERROR("Can't rename new %s\n", historyFileName);
+}
+
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+#include "../mesh/generated/meshtastic/telemetry.pb.h"
+#include "configuration.h"
+#include <vector>
+
+class JSONValue;
+
+// Recording can be left out entirely, STM32WL only has 64 KB of RAM
+#ifndef TELEMETRY_HISTORY
+#ifdef ARCH_STM32WL
+#define TELEMETRY_HISTORY 0
+#else
+#define TELEMETRY_HISTORY 1
+#endif
+#endif
+
+// How many buckets each resolution keeps, per metric. A metric costs about 1.6 KB on ESP32 and Portduino, and about
+// 0.75 KB with the shorter history of the other targets. The four device metrics are always recorded
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#ifndef TELEMETRY_HISTORY_RAW
+#define TELEMETRY_HISTORY_RAW 32 // Most recent readings, as recorded
+#endif
+#ifndef TELEMETRY_HISTORY_MINUTES
+#define TELEMETRY_HISTORY_MINUTES 30 // Half an hour of 1 minute buckets
+#endif
+#ifndef TELEMETRY_HISTORY_QUARTERS
+#define TELEMETRY_HISTORY_QUARTERS 32 // Eight hours of 15 minute buckets
+#endif
+#else
+#ifndef TELEMETRY_HISTORY_RAW
+#define TELEMETRY_HISTORY_RAW 8
+#endif
+#ifndef TELEMETRY_HISTORY_MINUTES
+#define TELEMETRY_HISTORY_MINUTES 15 // A quarter of an hour of 1 minute buckets
+#endif
+#ifndef TELEMETRY_HISTORY_QUARTERS
+#define TELEMETRY_HISTORY_QUARTERS 16 // Four hours of 15 minute buckets
+#endif
+#endif
+#ifndef TELEMETRY_HISTORY_HOURS
+#define TELEMETRY_HISTORY_HOURS 24 // A day of hourly buckets
+#endif
+
+enum TelemetryMetric {
+    METRIC_BATTERY_LEVEL,
+    METRIC_VOLTAGE,
+    METRIC_CHANNEL_UTILIZATION,
+    METRIC_AIR_UTIL_TX,
+    METRIC_TEMPERATURE,
+    METRIC_RELATIVE_HUMIDITY,
+    METRIC_BAROMETRIC_PRESSURE,
+    NUM_TELEMETRY_METRICS
+};
+
+enum TelemetryResolution { RESOLUTION_RAW, RESOLUTION_MINUTE, RESOLUTION_QUARTER, RESOLUTION_HOUR, NUM_TELEMETRY_RESOLUTIONS };
+
+/// One query result. For RESOLUTION_RAW it is a single reading and min == max == avg
+struct TelemetryBucket {
+    uint32_t time; // Unix time the bucket starts at
+    float min;
+    float max;
+    float avg;
+    uint16_t count; // Readings that went into it
+};
+
+/**
+ * Recent history of our own telemetry, kept in RAM at several resolutions so a day of readings can be
+ * handed out in one go instead of one packet per reading. On Portduino it is also saved to disk.
+ *
+ * Readings are only recorded once we know the time, so the buckets line up with the wall clock.
+ */
+class TelemetryHistory
+{
+  public:
+    /// Record every metric present in a device or environment telemetry reading
+    void record(const meshtastic_Telemetry &t);
+    void record(TelemetryMetric metric, float value, uint32_t time);
+
+    /// Append the buckets of a metric that start at or after since, oldest first. Returns how many were added
+    size_t query(TelemetryMetric metric, TelemetryResolution resolution, uint32_t since,
+                 std::vector<TelemetryBucket> &results) const;
+
+    /// Every metric we have buckets for since then, as served by the /json/telemetry endpoints. The caller deletes it
+    JSONValue *toJSON(TelemetryResolution resolution, uint32_t since) const;
+
+    static const char *metricName(TelemetryMetric metric);
+    static uint32_t resolutionSeconds(TelemetryResolution resolution);
+
+    /// "raw", "minute" or "quarter", anything else (or NULL) is RESOLUTION_HOUR
+    static TelemetryResolution parseResolution(const char *name);
+
+  private:
+    struct Aggregate {
+        float min;
+        float max;
+        float sum;
+        uint16_t count;
+    };
+
+    /// A ring of fixed width buckets, indexed by time / width
+    template <size_t N, uint32_t WIDTH> struct Tier {
+        Aggregate buckets[N];
+        uint32_t newest; // time / WIDTH of the newest bucket, 0 while the tier is empty
+
+        void add(float value, uint32_t time);
+        size_t query(uint32_t since, std::vector<TelemetryBucket> &results) const;
+    };
+
+    struct Reading {
+        uint32_t time;
+        float value;
+    };
+
+    struct Series {
+        Reading raw[TELEMETRY_HISTORY_RAW];
+        uint16_t rawNext;  // Where the next reading goes
+        uint16_t rawCount; // How many of raw are in use
+        Tier<TELEMETRY_HISTORY_MINUTES, 60> minutes;
+        Tier<TELEMETRY_HISTORY_QUARTERS, 15 * 60> quarters;
+        Tier<TELEMETRY_HISTORY_HOURS, 60 * 60> hours;
+    };
+
+    // Allocated on the first reading, so nodes without e.g. environment sensors don't pay for those series
+    Series *series[NUM_TELEMETRY_METRICS] = {};
+
+#ifdef ARCH_PORTDUINO
+    bool loaded = false;
+    uint32_t lastSave = 0;
+
+    void loadFromDisk();
+    void saveToDisk();
+#endif
+};
+
+extern TelemetryHistory telemetryHistory;
@@ -8,6 +8,13 @@ bool TraceRouteModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, m
     // Only handle a response
     if (mp.decoded.request_id) {
         printRoute(r, mp.to, mp.from);
+
+        // The route lists the nodes that relayed our request, so each is one hop further than the one before it
+        if (mp.to == nodeDB->getNodeNum() && router) {
+            for (uint8_t i = 0; i < r->route_count; i++)
+                router->learnHopsAway(r->route[i], i);
+            router->learnHopsAway(mp.from, r->route_count);
+        }
     }
 
     return false; // let it be handled by RoutingModule
@@ -59,6 +59,9 @@ class MQTT : private concurrency::OSThread
      */
     void onSend(const meshtastic_MeshPacket &mp, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex);
 
+    /// The JSON representation of a decoded packet, as published to the json/ topic
+    std::string meshPacketToJson(meshtastic_MeshPacket *mp);
+
     /** Attempt to connect to server if necessary
      */
     void reconnect();
@@ -109,9 +112,6 @@ class MQTT : private concurrency::OSThread
     /// Called when a new publish arrives from the MQTT server
     void onReceive(char *topic, byte *payload, size_t length);
 
-    /// Called when a new publish arrives from the MQTT server
-    std::string meshPacketToJson(meshtastic_MeshPacket *mp);
-
     void publishStatus();
     void publishQueuedMessages();
 
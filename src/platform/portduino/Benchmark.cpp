@@ -0,0 +1,413 @@
+#include "Benchmark.h"
+#include "MeshPacketQueue.h"
+#include "NodeDB.h"
+#include "PacketHistory.h"
+#include "PortduinoGlue.h"
+#include "RadioInterface.h"
+#include "Router.h"
+#include "TxBackoff.h"
+#include "main.h"
+#include "mesh/compression/PayloadCompression.h"
+#if !MESHTASTIC_EXCLUDE_MQTT
+#include "mqtt/MQTT.h"
+#endif
+#include <chrono>
+#include <new>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+extern "C" {
+#include "mesh/compression/unishox2.h"
+}
+
+#define BENCHMARK_ITERATIONS 20000
+#define BENCHMARK_CORPUS_SIZE 64
+
+// The contention simulation: how many nodes, and the size of their packets (header included)
+#define CONTENTION_SIM_NODES 20
+#define CONTENTION_SIM_PACKET_LEN 60
+#define CONTENTION_SIM_SECONDS 3600
+#define CONTENTION_SIM_RETRIES 3
+#define CONTENTION_SIM_REBROADCASTERS 4
+
+bool benchmarkRequested;
+
+extern RadioInterface *rIf;
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+// Heap allocations made through operator new, only counted while a benchmark is timing. Replacing the global operators
+// affects the whole binary, so this is only built into the native-benchmark environment (-DBENCHMARK_COUNT_ALLOCATIONS)
+static bool countAllocations;
+static uint64_t allocations;
+
+void *operator new(size_t size)
+{
+    if (countAllocations)
+        allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept
+{
+    free(p);
+}
+#endif
+
+/// Run op(i) for i in [0, iterations) and print its cost. Any copying op does to set up its input is included.
+template <typename F> static void benchmark(const char *name, uint32_t iterations, F &&op)
+{
+    op(0); // warm up, so lazily created state isn't billed to the first iteration
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    allocations = 0;
+    countAllocations = true;
+#endif
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+        op(i);
+    auto end = std::chrono::steady_clock::now();
+
+    double nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    countAllocations = false;
+    printf("%-40s %10u %12.1f %12.2f\n", name, iterations, nsPerOp, double(allocations) / iterations);
+#else
+    printf("%-40s %10u %12.1f %12s\n", name, iterations, nsPerOp, "-");
+#endif
+}
+
+static const char *const corpusText[] = {
+    "ok",
+    "Hello from the trailhead, anyone copy?",
+    "Meet at the north parking lot at 14:30, bring the spare antenna and a battery pack",
+    "Node 3 is back online after the firmware update. RSSI looks a lot better than yesterday from the ridge.",
+};
+
+// Samples of what each payload compression dictionary is meant for
+static const char *const dictionarySamples[NUM_PAYLOAD_DICTIONARIES][2] = {
+    {"Hello from the trailhead, anyone copy?",
+     "Meet at the north parking lot at 14:30, bring the spare antenna and a battery pack"},
+    {"Motion detected", "Are you going to the meeting at the ranger station this evening?"},
+    {"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?><event version=\"2.0\" uid=\"ANDROID-5e1f\" "
+     "type=\"a-f-G-U-C\" time=\"2024-05-01T12:00:00.000Z\" how=\"m-g\"><point lat=\"47.37\" lon=\"8.54\" hae=\"408\"/>",
+     "<event version=\"2.0\" uid=\"GeoChat.ANDROID-5e1f\" type=\"b-t-f\" time=\"2024-05-01T12:01:30.000Z\">"},
+    {"{\"temperature\": 21.5, \"humidity\": 40.2, \"voltage\": 3.71}",
+     "{\"node\": \"!a1b2c3d4\", \"env\": {\"temperature\": -3.25, \"pressure\": 1013.2}}"},
+};
+
+static inline uint64_t readCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0; // No portable cycle counter, only ns/byte is reported
+#endif
+}
+
+/// Compression ratio and cost per input byte of each payload compression dictionary on its samples
+static void benchmarkCompression()
+{
+    printf("\n%-40s %10s %12s %12s\n", "payload compression", "ratio", "ns/byte", "cycles/byte");
+    uint8_t out[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    for (int d = 0; d < NUM_PAYLOAD_DICTIONARIES; d++) {
+        size_t in = 0, compressed = 0;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startCycles = readCycleCounter();
+        for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            const char *text = dictionarySamples[d][i % 2];
+            size_t len = strlen(text);
+            in += len;
+            size_t c = PayloadCompression::compressBytes((PayloadDictionary)d, (const uint8_t *)text, len, out, sizeof(out));
+            compressed += c ? c : len; // Sent as is when it doesn't compress
+        }
+        uint64_t cycles = readCycleCounter() - startCycles;
+        auto end = std::chrono::steady_clock::now();
+
+        char name[48];
+        snprintf(name, sizeof(name), "compress %s", PayloadCompression::dictionaryName((PayloadDictionary)d));
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        printf("%-40s %10.2f %12.1f %12.1f\n", name, double(in) / compressed, ns / in, double(cycles) / in);
+    }
+}
+
+/// One simulated node: its queue, the slot its transmit timer fires in, and its back-off
+struct SimNode {
+    uint32_t queued;     // Packets waiting, the one we are sending included
+    uint32_t originals;  // How many of those are ours, for others to rebroadcast. We send them first
+    uint32_t retries;    // Of the packet we are sending
+    uint64_t timerSlot;  // 0 while nothing is scheduled
+    uint64_t onAirUntil; // While we're transmitting, the first slot after
+    bool collided;
+    TxBackoff backoff;
+};
+
+/**
+ * Delivery ratio of CONTENTION_SIM_NODES nodes that all hear each other. Each sends packets at random times, and
+ * CONTENTION_SIM_REBROADCASTERS others rebroadcast each one as soon as they hear it, which is what makes them contend
+ * in bursts. offeredLoad is the airtime all of that asks for, as a share of the channel.
+ *
+ * Time advances in slots, with our radio's slot and packet times and its contention window. Channel activity detection
+ * catches any transmission started in an earlier slot, so packets collide when timers fire in the same slot. The sender
+ * learns that from the missing ack as soon as it's done transmitting, and retries. With adaptive false the window comes
+ * from the channel utilization alone, as it did before TxBackoff.
+ */
+static float simulateContention(float offeredLoad, bool adaptive)
+{
+    std::mt19937 rng(4242); // The same traffic for both variants
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::uniform_int_distribution<uint32_t> otherNode(1, CONTENTION_SIM_NODES - 1);
+
+    uint32_t slotMsec = rIf->getSlotTimeMsec();
+    uint32_t airSlots = (rIf->getPacketTime(CONTENTION_SIM_PACKET_LEN) + slotMsec - 1) / slotMsec;
+    uint64_t numSlots = CONTENTION_SIM_SECONDS * 1000ULL / slotMsec;
+    float originalsPerSlot = offeredLoad / (CONTENTION_SIM_NODES * airSlots * (1 + CONTENTION_SIM_REBROADCASTERS));
+    // The busy share of the last 10 seconds or so, as the short-term view of AirTime::congestionPercent() would see it
+    float utilDecay = float(slotMsec) / 10000;
+
+    SimNode nodes[CONTENTION_SIM_NODES] = {};
+    const TxBackoff none;
+    uint64_t channelBusyUntil = 0;
+    float util = 0;
+    uint32_t offered = 0, delivered = 0;
+
+    auto schedule = [&](SimNode &n, uint64_t now) {
+        uint8_t cwSize = rIf->getCWsize(util, adaptive ? n.backoff : none);
+        n.timerSlot = now + 1 + std::uniform_int_distribution<uint32_t>(0, (1 << cwSize) - 1)(rng);
+    };
+    auto enqueue = [&](SimNode &n, uint64_t now, bool original) {
+        offered++;
+        if (n.queued == MAX_TX_QUEUE)
+            return; // Dropped, as MeshPacketQueue would when full
+        n.originals += original;
+        if (n.queued++ == 0 && !n.onAirUntil)
+            schedule(n, now);
+    };
+
+    std::vector<SimNode *> starting;
+    for (uint64_t t = 1; t <= numSlots; t++) {
+        for (SimNode &n : nodes) {
+            if (uniform(rng) < originalsPerSlot)
+                enqueue(n, t, true);
+
+            if (n.onAirUntil == t) {
+                n.onAirUntil = 0;
+                n.backoff.noteSuccess();
+                if (!n.collided || ++n.retries > CONTENTION_SIM_RETRIES) {
+                    bool original = n.originals > 0;
+                    n.originals -= original;
+                    n.queued--;
+                    n.retries = 0;
+                    if (!n.collided) {
+                        delivered++;
+                        for (int i = 0; original && i < CONTENTION_SIM_REBROADCASTERS; i++)
+                            enqueue(nodes[(&n - nodes + otherNode(rng)) % CONTENTION_SIM_NODES], t, false);
+                    }
+                } else {
+                    n.backoff.noteCollision();
+                }
+                if (n.queued)
+                    schedule(n, t);
+            }
+
+            if (n.timerSlot == t) {
+                n.timerSlot = 0;
+                if (t < channelBusyUntil) {
+                    n.backoff.noteDeferred();
+                    schedule(n, t);
+                } else {
+                    starting.push_back(&n);
+                }
+            }
+        }
+
+        for (SimNode *n : starting) {
+            n->onAirUntil = t + airSlots;
+            n->collided = starting.size() > 1;
+        }
+        if (!starting.empty())
+            channelBusyUntil = t + airSlots;
+        starting.clear();
+
+        util += ((t < channelBusyUntil ? 100.0f : 0.0f) - util) * utilDecay;
+    }
+
+    return offered ? float(delivered) / offered : 0;
+}
+
+/// Delivery ratio against offered load, with and without the adaptive back-off
+static void benchmarkContention()
+{
+    if (!rIf) {
+        printf("\n%-40s skipped, no radio interface\n", "contention simulation");
+        return;
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "delivery ratio, %d nodes", CONTENTION_SIM_NODES);
+    printf("\n%-40s %10s %12s %12s\n", "contention simulation", "load", "static", "adaptive");
+    const float loads[] = {0.1f, 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f};
+    for (float load : loads)
+        printf("%-40s %10.2f %12.3f %12.3f\n", name, load, simulateContention(load, false), simulateContention(load, true));
+}
+
+/**
+ * A repeatable mix of the traffic a busy mesh carries: text messages, positions and node info,
+ * from a spread of senders, to broadcast and to us.
+ */
+static void buildCorpus(std::vector<meshtastic_MeshPacket> &corpus)
+{
+    for (uint32_t i = 0; i < BENCHMARK_CORPUS_SIZE; i++) {
+        meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+        p.from = 0x10000000 + (i % 16);
+        p.to = (i % 5) ? NODENUM_BROADCAST : nodeDB->getNodeNum();
+        p.id = 0x1000 + i;
+        p.hop_limit = 3;
+        p.channel = 0;
+        p.want_ack = (p.to != NODENUM_BROADCAST);
+        p.priority = (i % 3) ? meshtastic_MeshPacket_Priority_DEFAULT : meshtastic_MeshPacket_Priority_RELIABLE;
+        p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+
+        meshtastic_Data &d = p.decoded;
+        switch (i % 3) {
+        case 0: {
+            const char *text = corpusText[(i / 3) % (sizeof(corpusText) / sizeof(corpusText[0]))];
+            d.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+            d.payload.size = strlen(text);
+            memcpy(d.payload.bytes, text, d.payload.size);
+            break;
+        }
+        case 1: {
+            meshtastic_Position pos = meshtastic_Position_init_zero;
+            pos.has_latitude_i = pos.has_longitude_i = pos.has_altitude = true;
+            pos.latitude_i = 473000000 + i * 1234;
+            pos.longitude_i = 85000000 - i * 4321;
+            pos.altitude = 400 + i;
+            pos.time = 1700000000 + i * 30;
+            pos.precision_bits = 32;
+            d.portnum = meshtastic_PortNum_POSITION_APP;
+            d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_Position_msg, &pos);
+            break;
+        }
+        default: {
+            meshtastic_User user = meshtastic_User_init_zero;
+            snprintf(user.id, sizeof(user.id), "!%08x", p.from);
+            snprintf(user.long_name, sizeof(user.long_name), "Benchmark node %u", i);
+            snprintf(user.short_name, sizeof(user.short_name), "B%02u", i % 100);
+            user.hw_model = meshtastic_HardwareModel_PORTDUINO;
+            d.portnum = meshtastic_PortNum_NODEINFO_APP;
+            d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_User_msg, &user);
+            break;
+        }
+        }
+        corpus.push_back(p);
+    }
+}
+
+void runBenchmarks()
+{
+    // Keep per packet debug logging out of the timings
+    int logLevel = settingsMap[logoutputlevel];
+    settingsMap[logoutputlevel] = level_warn;
+
+    std::vector<meshtastic_MeshPacket> corpus;
+    buildCorpus(corpus);
+
+    std::vector<meshtastic_MeshPacket> encrypted = corpus;
+    for (auto &p : encrypted)
+        perhapsEncode(&p);
+
+    printf("%-40s %10s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+#ifndef BENCHMARK_COUNT_ALLOCATIONS
+    printf("(allocations are only counted by the native-benchmark build)\n");
+#endif
+
+    meshtastic_MeshPacket scratch;
+    benchmark("perhapsEncode", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        scratch = corpus[i % BENCHMARK_CORPUS_SIZE];
+        perhapsEncode(&scratch);
+    });
+    benchmark("perhapsDecode", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        scratch = encrypted[i % BENCHMARK_CORPUS_SIZE];
+        perhapsDecode(&scratch);
+    });
+
+    // Every packet id turns up twice, the way a flood reaches us from more than one neighbour
+    PacketHistory history;
+    benchmark("PacketHistory::wasSeenRecently", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        scratch.from = 0x10000000 + (i % 50);
+        scratch.id = i / 2;
+        history.wasSeenRecently(&scratch);
+    });
+
+    // Enqueue every time, dequeue every other time, so the queue fills up and then has to evict
+    MeshPacketQueue queue(MAX_TX_QUEUE);
+    const meshtastic_MeshPacket_Priority queuePriorities[] = {
+        meshtastic_MeshPacket_Priority_BACKGROUND, meshtastic_MeshPacket_Priority_DEFAULT, meshtastic_MeshPacket_Priority_DEFAULT,
+        meshtastic_MeshPacket_Priority_RELIABLE, meshtastic_MeshPacket_Priority_ACK};
+    benchmark("MeshPacketQueue enqueue/evict", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        meshtastic_MeshPacket *p = packetPool.allocCopy(corpus[i % BENCHMARK_CORPUS_SIZE]);
+        p->priority = queuePriorities[i % (sizeof(queuePriorities) / sizeof(queuePriorities[0]))];
+        if (!queue.enqueue(p))
+            packetPool.release(p);
+        if (i & 1)
+            packetPool.release(queue.dequeue());
+    });
+    while (!queue.empty())
+        packetPool.release(queue.dequeue());
+
+    // Half of the lookups are for nodes we don't know
+    std::vector<NodeNum> nums;
+    for (size_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
+        nums.push_back(nodeDB->getMeshNodeByIndex(i)->num);
+        nums.push_back(0x20000000 + i);
+    }
+    benchmark("NodeDB::getMeshNode", BENCHMARK_ITERATIONS, [&](uint32_t i) { nodeDB->getMeshNode(nums[i % nums.size()]); });
+
+    const meshtastic_FromRadio emptyFromRadio = meshtastic_FromRadio_init_zero;
+    std::vector<meshtastic_FromRadio> fromRadios(BENCHMARK_CORPUS_SIZE, emptyFromRadio);
+    for (size_t i = 0; i < fromRadios.size(); i++) {
+        fromRadios[i].which_payload_variant = meshtastic_FromRadio_packet_tag;
+        fromRadios[i].packet = corpus[i];
+    }
+    uint8_t fromRadioBytes[meshtastic_FromRadio_size];
+    benchmark("pb_encode_to_bytes FromRadio", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        pb_encode_to_bytes(fromRadioBytes, sizeof(fromRadioBytes), &meshtastic_FromRadio_msg,
+                           &fromRadios[i % BENCHMARK_CORPUS_SIZE]);
+    });
+
+#if !MESHTASTIC_EXCLUDE_MQTT
+    if (mqtt)
+        benchmark("MQTT::meshPacketToJson", BENCHMARK_ITERATIONS,
+                  [&](uint32_t i) { mqtt->meshPacketToJson(&corpus[i % BENCHMARK_CORPUS_SIZE]); });
+    else
+        printf("%-40s skipped, MQTT is not enabled\n", "MQTT::meshPacketToJson");
+#endif
+
+    char compressed[meshtastic_Constants_DATA_PAYLOAD_LEN * 2];
+    const size_t numTexts = sizeof(corpusText) / sizeof(corpusText[0]);
+    benchmark("unishox2_compress_simple", BENCHMARK_ITERATIONS, [&](uint32_t i) {
+        const char *text = corpusText[i % numTexts];
+        unishox2_compress_simple(text, strlen(text), compressed);
+    });
+
+    if (rIf)
+        benchmark("RadioInterface::getPacketTime", BENCHMARK_ITERATIONS,
+                  [&](uint32_t i) { rIf->getPacketTime(&corpus[i % BENCHMARK_CORPUS_SIZE]); });
+    else
+        printf("%-40s skipped, no radio interface\n", "RadioInterface::getPacketTime");
+
+    benchmarkCompression();
+    benchmarkContention();
+
+    settingsMap[logoutputlevel] = logLevel;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/// Set by the --benchmark command line option
+extern bool benchmarkRequested;
+
+/**
+ * Time the mesh hot paths in isolation and print ns/op and heap allocations/op for each.
+ * Runs on the native build once setup() is done, so the router, channels and NodeDB are the real ones.
+ */
+void runBenchmarks();
@@ -0,0 +1,130 @@
+#include "NodeStore.h"
+#include "configuration.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <pb_common.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const uint32_t NODE_STORE_MAGIC = 0x4e444232; // "NDB2", NDB1 stores had no layout hash
+
+static void hashValue(uint32_t &hash, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 16777619; // FNV-1a
+    }
+}
+
+static void hashFields(uint32_t &hash, const pb_msgdesc_t *desc)
+{
+    static uint8_t scratch[sizeof(meshtastic_NodeInfoLite)]; // Only used to work out field offsets, never read
+    pb_field_iter_t iter;
+    if (!pb_field_iter_begin(&iter, desc, scratch))
+        return;
+    do {
+        hashValue(hash, iter.tag);
+        hashValue(hash, iter.type);
+        hashValue(hash, iter.data_size);
+        hashValue(hash, iter.array_size);
+        hashValue(hash, (uint8_t *)iter.pData - scratch);
+        if (iter.submsg_desc)
+            hashFields(hash, iter.submsg_desc);
+    } while (pb_field_iter_next(&iter));
+}
+
+uint32_t NodeStore::layoutHash()
+{
+    static uint32_t hash = 0;
+    if (!hash) {
+        hash = 2166136261u;
+        hashFields(hash, &meshtastic_NodeInfoLite_msg);
+    }
+    return hash;
+}
+
+bool NodeStore::open(const std::string &path, size_t capacity)
+{
+    close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Can't open node store %s\n", path.c_str());
+        return false;
+    }
+
+    // Read the old header first, the file is resized to the new capacity below
+    Header old = {};
+    bool valid = (pread(fd, &old, sizeof(old), 0) == sizeof(old)) && old.magic == NODE_STORE_MAGIC &&
+                 old.recordSize == sizeof(meshtastic_NodeInfoLite) && old.layout == layoutHash();
+    if (!valid && old.magic)
+        LOG_WARN("Discarding incompatible node store %s\n", path.c_str());
+
+    mappedSize = sizeof(Header) + capacity * sizeof(meshtastic_NodeInfoLite);
+    if (ftruncate(fd, mappedSize) != 0) {
+        LOG_ERROR("Can't resize node store %s\n", path.c_str());
+        close();
+        return false;
+    }
+
+    void *mapped = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("Can't map node store %s\n", path.c_str());
+        close();
+        return false;
+    }
+    header = (Header *)mapped;
+    records = (meshtastic_NodeInfoLite *)(header + 1);
+
+    header->magic = NODE_STORE_MAGIC;
+    header->recordSize = sizeof(meshtastic_NodeInfoLite);
+    header->layout = layoutHash();
+    header->capacity = capacity;
+    header->count = valid ? std::min((size_t)old.count, capacity) : 0;
+
+    LOG_INFO("Opened node store %s, %u of %u records in use\n", path.c_str(), header->count, header->capacity);
+    return true;
+}
+
+void NodeStore::close()
+{
+    if (header) {
+        msync(header, mappedSize, MS_SYNC);
+        munmap(header, mappedSize);
+        header = NULL;
+        records = NULL;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+size_t NodeStore::load(std::vector<meshtastic_NodeInfoLite> &nodes, size_t max) const
+{
+    size_t count = std::min({size(), max, nodes.size()});
+    if (count)
+        memcpy(nodes.data(), records, count * sizeof(meshtastic_NodeInfoLite));
+    return count;
+}
+
+void NodeStore::save(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count)
+{
+    if (!header)
+        return;
+
+    count = std::min(count, (size_t)header->capacity);
+    size_t changed = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Leave unchanged records alone, so their pages stay clean
+        if (memcmp(&records[i], &nodes[i], sizeof(meshtastic_NodeInfoLite)) != 0) {
+            records[i] = nodes[i];
+            changed++;
+        }
+    }
+    header->count = count;
+
+    msync(header, mappedSize, MS_ASYNC);
+    LOG_DEBUG("Saved node store, %u of %u records changed\n", (unsigned)changed, (unsigned)count);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "mesh/generated/meshtastic/deviceonly.pb.h"
+#include <string>
+#include <vector>
+
+/**
+ * The NodeDB of a Portduino build, kept in its own file of fixed size records rather than inside the DeviceState
+ * protobuf, so a DB of tens of thousands of nodes doesn't have to be encoded in one go on every save.
+ *
+ * The file is memory mapped. Loading copies the records straight into NodeDB's array (the kernel pages them in as they
+ * are read), and saving only writes the records that changed, so only those pages are written back to disk.
+ */
+class NodeStore
+{
+  public:
+    ~NodeStore() { close(); }
+
+    /// Map the store at path (creating it if needed) with room for capacity records
+    bool open(const std::string &path, size_t capacity);
+    void close();
+
+    bool isOpen() const { return header != NULL; }
+
+    /// Number of records the file holds
+    size_t size() const { return header ? header->count : 0; }
+
+    /// Copy the (up to) max stored records into nodes. Returns how many were copied
+    size_t load(std::vector<meshtastic_NodeInfoLite> &nodes, size_t max) const;
+
+    /// Write the first count nodes, only touching the records that changed
+    void save(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t count);
+
+  private:
+    // A store written by a build with a different NodeInfoLite, in size or in layout, is discarded
+    struct Header {
+        uint32_t magic;
+        uint32_t recordSize;
+        uint32_t layout; // layoutHash() of the build that wrote it
+        uint32_t capacity;
+        uint32_t count;
+    };
+
+    /// A hash of the tag, type, size and offset of every field of NodeInfoLite, submessages included
+    static uint32_t layoutHash();
+
+    int fd = -1;
+    Header *header = NULL;
+    meshtastic_NodeInfoLite *records = NULL;
+    size_t mappedSize = 0;
+};
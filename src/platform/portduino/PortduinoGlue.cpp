@@ -1,3 +1,4 @@
+#include "Benchmark.h"
 #include "CryptoEngine.h"
 #include "PortduinoGPIO.h"
 #include "SPIChip.h"
@@ -48,6 +49,9 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'c':
         configPath = arg;
         break;
+    case 'b':
+        benchmarkRequested = true;
+        break;
     case ARGP_KEY_ARG:
         return 0;
     default:
@@ -60,6 +64,7 @@ void portduinoCustomInit()
 {
     static struct argp_option options[] = {{"port", 'p', "PORT", 0, "The TCP port to use."},
                                            {"config", 'c', "CONFIG_PATH", 0, "Full path of the .yaml config file to use."},
+                                           {"benchmark", 'b', 0, 0, "Time the mesh hot paths, print the results and exit."},
                                            {0}};
     static void *childArguments;
     static char doc[] = "Meshtastic native build.";
@@ -71,8 +71,10 @@ void SimRadio::handleTransmitInterrupt()
 {
     // This can be null if we forced the device to enter standby mode.  In that case
     // ignore the transmit interrupt
-    if (sendingPacket)
+    if (sendingPacket) {
+        backoff.noteSuccess();
         completeSending();
+    }
 }
 
 void SimRadio::completeSending()
@@ -153,10 +155,12 @@ void SimRadio::onNotify(uint32_t notification)
         if (!txQueue.empty()) {
             if (!canSendImmediately()) {
                 // LOG_DEBUG("Currently Rx/Tx-ing: set random delay\n");
+                backoff.noteDeferred();
                 setTransmitDelay(); // currently Rx/Tx-ing: reset random delay
             } else {
                 if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
                     // LOG_DEBUG("Channel is active: set random delay\n");
+                    backoff.noteDeferred();
                     setTransmitDelay(); // reset random delay
                 } else {
                     // Send any outgoing packets we have ready
@@ -2,6 +2,7 @@
 #include "configuration.h"
 #include "graphics/Screen.h"
 #include "main.h"
+#include "modules/RangeTestModule.h"
 #include "power.h"
 #if defined(ARCH_PORTDUINO)
 #include "api/WiFiServerAPI.h"
@@ -13,6 +14,8 @@ void powerCommandsCheck()
 {
     if (rebootAtMsec && millis() > rebootAtMsec) {
         LOG_INFO("Rebooting\n");
+        if (rangeTestModuleRadio)
+            rangeTestModuleRadio->flushFile();
 #if defined(ARCH_ESP32)
         ESP.restart();
 #elif defined(ARCH_NRF52)
@@ -47,6 +50,8 @@ void powerCommandsCheck()
         playShutdownMelody();
         power->shutdown();
 #elif defined(ARCH_PORTDUINO)
+        if (rangeTestModuleRadio)
+            rangeTestModuleRadio->flushFile();
         exit(EXIT_SUCCESS);
 #else
         LOG_WARN("FIXME implement shutdown for this platform");
@@ -54,6 +54,27 @@ XModemAdapter xModem;
 
 XModemAdapter::XModemAdapter() {}
 
+// CRC-16 CCITT (polynomial 0x1021) of every byte value, so the checksum takes one lookup per byte
+static const uint16_t crc16Table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7, 0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce,
+    0xf1ef, 0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6, 0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c,
+    0xf3ff, 0xe3de, 0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485, 0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee,
+    0xf5cf, 0xc5ac, 0xd58d, 0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4, 0xb75b, 0xa77a, 0x9719, 0x8738,
+    0xf7df, 0xe7fe, 0xd79d, 0xc7bc, 0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823, 0xc9cc, 0xd9ed, 0xe98e,
+    0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b, 0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12, 0xdbfd, 0xcbdc,
+    0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a, 0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41, 0xedae,
+    0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49, 0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78, 0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e,
+    0xe16f, 0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067, 0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c,
+    0xe37f, 0xf35e, 0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256, 0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e,
+    0xe54f, 0xd52c, 0xc50d, 0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405, 0xa7db, 0xb7fa, 0x8799, 0x97b8,
+    0xe75f, 0xf77e, 0xc71d, 0xd73c, 0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634, 0xd94c, 0xc96d, 0xf90e,
+    0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab, 0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3, 0xcb7d, 0xdb5c,
+    0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a, 0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92, 0xfd2e,
+    0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9, 0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8, 0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1,
+    0x1ef0};
+
 /**
  * Calculates the CRC-16 CCITT checksum of the given buffer.
  *
@@ -63,16 +84,9 @@ XModemAdapter::XModemAdapter() {}
  */
 unsigned short XModemAdapter::crc16_ccitt(const pb_byte_t *buffer, int length)
 {
-    unsigned short crc16 = 0;
-    while (length != 0) {
-        crc16 = (unsigned char)(crc16 >> 8) | (crc16 << 8);
-        crc16 ^= *buffer;
-        crc16 ^= (unsigned char)(crc16 & 0xff) >> 4;
-        crc16 ^= (crc16 << 8) << 4;
-        crc16 ^= ((crc16 & 0xff) << 4) << 1;
-        buffer++;
-        length--;
-    }
+    uint16_t crc16 = 0;
+    while (length-- > 0)
+        crc16 = (crc16 << 8) ^ crc16Table[(crc16 >> 8) ^ *buffer++];
 
     return crc16;
 }
@@ -101,12 +115,96 @@ void XModemAdapter::sendControl(meshtastic_XModem_Control c)
 
 meshtastic_XModem XModemAdapter::getForPhone()
 {
-    return xmodemStore;
+    if (xmodemStore.control != meshtastic_XModem_Control_NUL || !isTransmitting || !hasPacket(nextSeq))
+        return xmodemStore;
+
+    // Data packets are built from the read ahead buffer as the phone asks for them
+    meshtastic_XModem p = meshtastic_XModem_init_zero;
+    size_t offset = (uint16_t)(nextSeq - windowBase) * XMODEM_CHUNK_SIZE;
+    p.control = meshtastic_XModem_Control_SOH;
+    p.seq = nextSeq;
+    p.buffer.size = (offset < buffered) ? min(buffered - offset, XMODEM_CHUNK_SIZE) : 0;
+    memcpy(p.buffer.bytes, sendBuffer + offset, p.buffer.size);
+    p.crc16 = crc16_ccitt(p.buffer.bytes, p.buffer.size);
+    LOG_DEBUG("XModem: Sending packet %d, %d Bytes.\n", p.seq, p.buffer.size);
+    return p;
 }
 
 void XModemAdapter::resetForPhone()
 {
+    if (xmodemStore.control != meshtastic_XModem_Control_NUL)
+        xmodemStore = meshtastic_XModem_init_zero;
+    else if (isTransmitting && hasPacket(nextSeq))
+        nextSeq++;
+}
+
+/// Open the transfer: read the first window ahead and offer packet 1 to the phone
+void XModemAdapter::startTransmit(uint16_t requestedWindow)
+{
+    window = constrain(requestedWindow, 1, XMODEM_MAX_WINDOW);
+    windowBase = nextSeq = 1;
+    buffered = 0;
+    fileEnded = false;
+    retrans = MAXRETRANS;
+    isTransmitting = true;
     xmodemStore = meshtastic_XModem_init_zero;
+    fillSendBuffer();
+    LOG_INFO("XModem: Transmitting file %s, window %d\n", filename, window);
+    packetReady.notifyObservers(nextSeq);
+}
+
+/// Top sendBuffer up to a full window with one read
+void XModemAdapter::fillSendBuffer()
+{
+    size_t wanted = window * XMODEM_CHUNK_SIZE - buffered;
+    if (fileEnded || wanted == 0)
+        return;
+    size_t got = file.read(sendBuffer + buffered, wanted);
+    buffered += got;
+    if (got < wanted)
+        fileEnded = true;
+}
+
+/**
+ * Is packet seq inside the window and do we have it? The packet after the last full one is always sent, even if
+ * empty, as a short packet is how the receiver knows the file is complete.
+ */
+bool XModemAdapter::hasPacket(uint16_t seq) const
+{
+    uint16_t index = seq - windowBase;
+    if (index >= window)
+        return false;
+    return index * XMODEM_CHUNK_SIZE < buffered || (fileEnded && index == buffered / XMODEM_CHUNK_SIZE);
+}
+
+/// Everything up to and including seq has arrived: slide the window past it, or finish if that was the last packet
+void XModemAdapter::acknowledge(uint16_t seq)
+{
+    uint16_t acked = seq - windowBase + 1;
+    if (acked == 0 || acked > (uint16_t)(nextSeq - windowBase))
+        return; // Duplicate, or for a packet we haven't sent
+
+    if (fileEnded && acked > buffered / XMODEM_CHUNK_SIZE) {
+        sendControl(meshtastic_XModem_Control_EOT);
+        LOG_INFO("XModem: Finished sending file %s\n", filename);
+        stopTransmit();
+        return;
+    }
+
+    size_t consumed = acked * XMODEM_CHUNK_SIZE;
+    memmove(sendBuffer, sendBuffer + consumed, buffered - consumed);
+    buffered -= consumed;
+    windowBase += acked;
+    retrans = MAXRETRANS; // reset retransmit counter
+    fillSendBuffer();
+    packetReady.notifyObservers(nextSeq);
+}
+
+void XModemAdapter::stopTransmit()
+{
+    file.close();
+    isTransmitting = false;
+    buffered = 0;
 }
 
 void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
@@ -114,7 +212,9 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
     switch (xmodemPacket.control) {
     case meshtastic_XModem_Control_SOH:
     case meshtastic_XModem_Control_STX:
-        if ((xmodemPacket.seq == 0) && !isReceiving && !isTransmitting) {
+        if (!isReceiving && !isTransmitting &&
+            (xmodemPacket.seq == 0 || (xmodemPacket.control == meshtastic_XModem_Control_STX &&
+                                       (xmodemPacket.seq & XMODEM_WINDOWED_SEQ_MASK) == XMODEM_WINDOWED_SEQ))) {
             // NULL packet has the destination filename
             memcpy(filename, &xmodemPacket.buffer.bytes, xmodemPacket.buffer.size);
             if (xmodemPacket.control == meshtastic_XModem_Control_SOH) { // Receive this file and put to Flash
@@ -129,22 +229,9 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
                 isReceiving = false;
                 break;
             } else { // Transmit this file from Flash
-                LOG_INFO("XModem: Transmitting file %s\n", filename);
                 file = FSCom.open(filename, FILE_O_READ);
                 if (file) {
-                    packetno = 1;
-                    isTransmitting = true;
-                    xmodemStore = meshtastic_XModem_init_zero;
-                    xmodemStore.control = meshtastic_XModem_Control_SOH;
-                    xmodemStore.seq = packetno;
-                    xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-                    xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
-                    LOG_DEBUG("XModem: STX Notify Sending packet %d, %d Bytes.\n", packetno, xmodemStore.buffer.size);
-                    if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
-                        isEOT = true;
-                        // send EOT on next Ack
-                    }
-                    packetReady.notifyObservers(packetno);
+                    startTransmit(xmodemPacket.seq & ~XMODEM_WINDOWED_SEQ_MASK); // 0 for stop-and-wait clients
                     break;
                 }
                 sendControl(meshtastic_XModem_Control_NAK);
@@ -168,7 +255,7 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
             } else if (isTransmitting) {
                 // just received something weird.
                 sendControl(meshtastic_XModem_Control_CAN);
-                isTransmitting = false;
+                stopTransmit();
                 break;
             }
         }
@@ -189,56 +276,29 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
         isReceiving = false;
         break;
     case meshtastic_XModem_Control_ACK:
-        // Acknowledge Send the next packet
+        // Acknowledge, slide the window and send what that frees up. Stop-and-wait clients don't number their ACKs
         if (isTransmitting) {
-            if (isEOT) {
-                sendControl(meshtastic_XModem_Control_EOT);
-                file.close();
-                LOG_INFO("XModem: Finished sending file %s\n", filename);
-                isTransmitting = false;
-                isEOT = false;
-                break;
-            }
-            retrans = MAXRETRANS; // reset retransmit counter
-            packetno++;
-            xmodemStore = meshtastic_XModem_init_zero;
-            xmodemStore.control = meshtastic_XModem_Control_SOH;
-            xmodemStore.seq = packetno;
-            xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-            xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
-            LOG_DEBUG("XModem: ACK Notify Sending packet %d, %d Bytes.\n", packetno, xmodemStore.buffer.size);
-            if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
-                isEOT = true;
-                // send EOT on next Ack
-            }
-            packetReady.notifyObservers(packetno);
+            acknowledge(window > 1 ? xmodemPacket.seq : windowBase);
         } else {
             // just received something weird.
             sendControl(meshtastic_XModem_Control_CAN);
         }
         break;
     case meshtastic_XModem_Control_NAK:
-        // Negative acknowledge. Send the same buffer again
+        // Negative acknowledge. Go back and send everything from the rejected packet again
         if (isTransmitting) {
             if (--retrans <= 0) {
                 sendControl(meshtastic_XModem_Control_CAN);
-                file.close();
                 LOG_INFO("XModem: Retransmit timeout, cancelling file %s\n", filename);
-                isTransmitting = false;
+                stopTransmit();
                 break;
             }
-            xmodemStore = meshtastic_XModem_init_zero;
-            xmodemStore.control = meshtastic_XModem_Control_SOH;
-            xmodemStore.seq = packetno;
-            file.seek((packetno - 1) * sizeof(meshtastic_XModem_buffer_t::bytes));
-            xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-            xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
-            LOG_DEBUG("XModem: NAK Notify Sending packet %d, %d Bytes.\n", packetno, xmodemStore.buffer.size);
-            if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
-                isEOT = true;
-                // send EOT on next Ack
-            }
-            packetReady.notifyObservers(packetno);
+            if (window == 1)
+                xmodemPacket.seq = windowBase;
+            if ((uint16_t)(xmodemPacket.seq - windowBase) < (uint16_t)(nextSeq - windowBase))
+                nextSeq = xmodemPacket.seq;
+            LOG_DEBUG("XModem: NAK, resending from packet %d\n", nextSeq);
+            packetReady.notifyObservers(nextSeq);
         } else {
             // just received something weird.
             sendControl(meshtastic_XModem_Control_CAN);
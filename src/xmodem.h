@@ -38,6 +38,25 @@
 
 #define MAXRETRANS 25
 
+// Most data packets we keep in flight when the client asks for a windowed transfer, each costs 128 bytes of RAM
+#ifndef XMODEM_MAX_WINDOW
+#define XMODEM_MAX_WINDOW 8
+#endif
+
+#define XMODEM_CHUNK_SIZE sizeof(meshtastic_XModem_buffer_t::bytes)
+
+// An STX request with seq XMODEM_WINDOWED_SEQ | window asks for a windowed transfer, plain stop-and-wait clients send seq 0
+#define XMODEM_WINDOWED_SEQ 0xFF00
+#define XMODEM_WINDOWED_SEQ_MASK 0xFF00
+
+/**
+ * Transfers files to and from the filesystem over the phone API.
+ *
+ * Sending a file is stop-and-wait by default: one packet per ACK. A client can ask for a sliding window by sending its
+ * STX request with seq XMODEM_WINDOWED_SEQ plus the number of packets it is willing to have in flight (1-255) instead
+ * of seq 0. In that mode we hand out up to that many packets (capped at XMODEM_MAX_WINDOW) without waiting, an ACK with
+ * seq N acknowledges every packet up to and including N, and a NAK with seq N makes us go back and resend from N.
+ */
 class XModemAdapter
 {
   public:
@@ -53,12 +72,20 @@ class XModemAdapter
   private:
     bool isReceiving = false;
     bool isTransmitting = false;
-    bool isEOT = false;
 
     int retrans = MAXRETRANS;
 
     uint16_t packetno = 0;
 
+    // Sending side. The file data from windowBase on is read ahead into sendBuffer, so a window is one read and
+    // retransmits don't touch the filesystem
+    uint16_t window = 1;     // Packets we may have in flight
+    uint16_t windowBase = 0; // Oldest packet not acknowledged yet
+    uint16_t nextSeq = 0;    // Next packet to hand to the phone
+    uint8_t sendBuffer[XMODEM_MAX_WINDOW * XMODEM_CHUNK_SIZE];
+    size_t buffered = 0;    // Bytes of sendBuffer in use
+    bool fileEnded = false; // The read ahead reached the end of the file
+
 #if defined(ARCH_NRF52) || defined(ARCH_STM32WL)
     File file = File(FSCom);
 #else
@@ -72,6 +99,12 @@ class XModemAdapter
     unsigned short crc16_ccitt(const pb_byte_t *buffer, int length);
     int check(const pb_byte_t *buf, int sz, unsigned short tcrc);
     void sendControl(meshtastic_XModem_Control c);
+
+    void startTransmit(uint16_t requestedWindow);
+    void fillSendBuffer();
+    bool hasPacket(uint16_t seq) const;
+    void acknowledge(uint16_t seq);
+    void stopTransmit();
 };
 
 extern XModemAdapter xModem;
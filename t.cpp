@@ -0,0 +1,7 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "old.inc"
+#include "tbl.inc"
+uint16_t nw(const unsigned char*b,int l){uint16_t c=0;while(l-->0)c=(c<<8)^crc16Table[(c>>8)^*b++];return c;}
+int main(){unsigned char b[300];for(int t=0;t<10000;t++){int l=rand()%300;for(int i=0;i<l;i++)b[i]=rand();if(old_crc(b,l)!=nw(b,l)){printf("MISMATCH\n");return 1;}}printf("ok %04x\n",nw((const unsigned char*)"123456789",9));}